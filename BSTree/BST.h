@@ -2,7 +2,7 @@
 #include <iostream>
 #include <utility>
 #include <algorithm>
-#include <queue>
+#include "../RBTree/TreeStats.h"
 
 #ifdef min
 #undef min
@@ -25,7 +25,7 @@ class BST
 		TKey key;
 		TValue value;
 
-		Node(TKey key, TValue value) : 
+		Node(const TKey& key, const TValue& value) : 
 			parent(nullptr), 
 			left(nullptr),
 			right(nullptr),
@@ -36,16 +36,34 @@ class BST
 	};
 
 public:
-	BST() : root(nullptr) {  }
+	BST() :
+		root(nullptr),
+		count(0),
+		lastInsertDepth(0),
+		maxInsertDepth(0)
+	{  }
 
 	~BST()
 	{
 		clean(root);
 	}
 
-	void insert(TKey key, TValue value);
+	void insert(const TKey& key, const TValue& value);
 
-	TValue* find(TKey key);
+	TValue* find(const TKey& key);
+
+	// Lookup by any type that compares with TKey through operator<,
+	// e.g. a string literal or string_view on a tree of std::string.
+	template <typename TLookup>
+	TValue* find(const TLookup& key)
+	{
+		Node* ptr = findNode(key);
+
+		if (ptr == nullptr)
+			return nullptr;
+
+		return &ptr->value;
+	}
 
 
 	std::pair<TKey, TValue> min();
@@ -57,32 +75,20 @@ public:
 		print(root);
 	}
 
-	TKey* successor(TKey key)
+	TKey* successor(const TKey& key)
 	{
 		Node * keyNode = findNode(key);
 
 		if (keyNode == nullptr)
 			return nullptr;
 
-		if (keyNode->right != nullptr)
-		{
-			Node * ptr = findMinNode(keyNode->right);
-			return &ptr->key;
-		}
-
-		Node * ptr = keyNode->parent;
-
-		while (ptr != nullptr && keyNode == ptr->right)
-		{
-			keyNode = ptr;
-			ptr = ptr->parent;
-		}
+		Node * ptr = nextNode(keyNode);
 
 		return ptr == nullptr ? nullptr : &(ptr->key);
 
 	}
 
-	TKey* predecessor(TKey key)
+	TKey* predecessor(const TKey& key)
 	{
 		Node * keyNode = findNode(key);
 
@@ -107,7 +113,7 @@ public:
 
 	}
 
-	void remove(TKey key)
+	void remove(const TKey& key)
 	{
 		Node *keyNode = findNode(key);
 
@@ -141,98 +147,105 @@ public:
 		}
 
 		delete keyNode;
+		count--;
+	}
+
+	size_t size() const
+	{
+		return count;
 	}
 
 	size_t height() const
 	{
-		if (root == nullptr)
-			return 0;
+		size_t h = 0;
+		walk([&h](const Node*, size_t depth) { h = std::max(h, depth); });
+		return h;
+	}
 
-		std::queue<Node *> queue;
+	algs::TreeCounters counters() const
+	{
+		algs::TreeCounters result = algs::TreeCounters();
+		result.nodeCount = count;
+		result.lastInsertDepth = lastInsertDepth;
+		result.maxInsertDepth = maxInsertDepth;
+		result.bytesPerNode = sizeof(Node);
+		return result;
+	}
 
-		size_t h = 0;
-		queue.push(root);
+	// O(n), see algs::statsAsync() to run it off the calling thread.
+	algs::TreeStats stats() const;
+	
 
-		while (true)
+private:
+	void clean(Node* node)
+	{
+		// Rotate left children up until the tree is a right-leaning list,
+		// deleting nodes as they reach the head of the list.
+		while (node != nullptr)
 		{
-			int nodeCount = queue.size();
-
-			if (nodeCount == 0)
-				return h;
+			if (node->left != nullptr)
+			{
+				Node * child = node->left;
+				node->left = child->right;
+				child->right = node;
+				node = child;
+			}
 			else
-				h++;
-
-			while (nodeCount > 0)
 			{
-				Node * node = queue.back();
-				queue.pop();
-
-				if (node->left != nullptr)
-					queue.push(node->left);
-
-				if (node->right != nullptr)
-					queue.push(node->right);
-
-				nodeCount--;
+				Node * next = node->right;
+				delete node;
+				node = next;
 			}
 		}
 	}
-	
 
-private:
-	void clean(Node* node)
+	void print(Node * node) const
 	{
 		if (node == nullptr)
 			return;
-		
-		clean(node->left);
-		clean(node->right);
 
-		delete node;
+		for (Node * ptr = findMinNode(node); ptr != nullptr; ptr = nextNode(ptr))
+			std::cout << ptr->key << "(" << ptr->value << ") ";
 	}
 
-	void print(Node * node) const
-	{
-		if (node == nullptr)
-			return;
+	template <typename TLookup>
+	Node* findNode(const TLookup& key);
 
-		print(node->left);
-		std::cout << node->key << "(" << node->value << ") ";
-		print(node->right);
-	}
+	Node* findMinNode(Node* node) const;
 
-	Node* findNode(TKey key);
+	Node* findMaxNode(Node* node) const;
 
-	Node* findMinNode(Node* node);
+	Node* nextNode(Node* node) const;
 
-	Node* findMaxNode(Node* node);
+	// Depth-first walk over parent pointers: no recursion and no auxiliary storage.
+	// Calls visit(node, depth) for every node in preorder, the root at depth 1.
+	template <typename TFunc>
+	void walk(TFunc visit) const;
 
 	void transplant(Node * prevNode, Node * newNode);
 
-	size_t height(Node * nodePtr) const
-	{
-		if (nodePtr == nullptr)
-			return 0;
-		return 1 + std::max(height(nodePtr->left), height(nodePtr->right));
-	}
-
 
 private:
-	Node * root;	
+	Node * root;
+	size_t count;
+	size_t lastInsertDepth;
+	size_t maxInsertDepth;
 };
 
 
 template <typename TKey, typename TValue>
-void BST<TKey, TValue>::insert(TKey key, TValue value)
+void BST<TKey, TValue>::insert(const TKey& key, const TValue& value)
 {
 	Node * newNode = new Node(key, value);
 
 	Node *tmp = nullptr;
 	Node *current = root;
+	size_t depth = 1;
 
 	while (current != nullptr)
 	{
 		tmp = current;
+		depth++;
 
 		if (newNode->key < current->key)
 		{
@@ -257,10 +270,81 @@ void BST<TKey, TValue>::insert(TKey key, TValue value)
 	{
 		tmp->right = newNode;
 	}
+
+	count++;
+	lastInsertDepth = depth;
+	maxInsertDepth = std::max(maxInsertDepth, depth);
+}
+
+template <typename TKey, typename TValue>
+algs::TreeStats BST<TKey, TValue>::stats() const
+{
+	algs::TreeStats result = algs::TreeStats();
+	result.nodeCount = count;
+	result.bytesPerNode = sizeof(Node);
+
+	if (root == nullptr)
+		return result;
+
+	size_t depthSum = 0;
+	walk([&result, &depthSum](const Node*, size_t depth)
+	{
+		if (result.depthHistogram.size() < depth)
+			result.depthHistogram.resize(depth);
+
+		result.depthHistogram[depth - 1]++;
+		depthSum += depth;
+	});
+
+	result.height = result.depthHistogram.size();
+	result.averageDepth = static_cast<double>(depthSum) / count;
+	return result;
+}
+
+template <typename TKey, typename TValue>
+template <typename TFunc>
+void BST<TKey, TValue>::walk(TFunc visit) const
+{
+	size_t depth = 1;
+	Node * prev = nullptr;
+	Node * node = root;
+
+	while (node != nullptr)
+	{
+		Node * next;
+
+		if (prev == node->parent)
+		{
+			visit(node, depth);
+
+			if (node->left != nullptr)
+				next = node->left;
+			else if (node->right != nullptr)
+				next = node->right;
+			else
+				next = node->parent;
+		}
+		else if (prev == node->left && node->right != nullptr)
+		{
+			next = node->right;
+		}
+		else
+		{
+			next = node->parent;
+		}
+
+		if (next == node->parent)
+			depth--;
+		else
+			depth++;
+
+		prev = node;
+		node = next;
+	}
 }
 
 template <typename TKey, typename TValue>
-TValue* BST<TKey, TValue>::find(TKey key)
+TValue* BST<TKey, TValue>::find(const TKey& key)
 {
 	Node* ptr = findNode(key);
 
@@ -286,23 +370,26 @@ std::pair<TKey, TValue> BST<TKey, TValue>::max()
 }
 
 template <typename TKey, typename TValue>
-typename BST<TKey, TValue>::Node* BST<TKey, TValue>::findNode(TKey key)
+template <typename TLookup>
+typename BST<TKey, TValue>::Node* BST<TKey, TValue>::findNode(const TLookup& key)
 {
 	Node* ptr = root;
 
-	while (ptr != nullptr && ptr->key != key)
+	while (ptr != nullptr)
 	{
 		if (key < ptr->key)
 			ptr = ptr->left;
-		else
+		else if (ptr->key < key)
 			ptr = ptr->right;
+		else
+			break;
 	}
 
 	return ptr;
 }
 
 template <typename TKey, typename TValue>
-typename BST<TKey, TValue>::Node* BST<TKey, TValue>::findMinNode(Node* node)
+typename BST<TKey, TValue>::Node* BST<TKey, TValue>::findMinNode(Node* node) const
 {
 	Node* ptr = node;
 
@@ -313,7 +400,7 @@ typename BST<TKey, TValue>::Node* BST<TKey, TValue>::findMinNode(Node* node)
 }
 
 template <typename TKey, typename TValue>
-typename BST<TKey, TValue>::Node* BST<TKey, TValue>::findMaxNode(Node* node)
+typename BST<TKey, TValue>::Node* BST<TKey, TValue>::findMaxNode(Node* node) const
 {
 	Node *ptr = node;
 
@@ -323,6 +410,23 @@ typename BST<TKey, TValue>::Node* BST<TKey, TValue>::findMaxNode(Node* node)
 	return ptr;
 }
 
+template <typename TKey, typename TValue>
+typename BST<TKey, TValue>::Node* BST<TKey, TValue>::nextNode(Node* node) const
+{
+	if (node->right != nullptr)
+		return findMinNode(node->right);
+
+	Node * ptr = node->parent;
+
+	while (ptr != nullptr && node == ptr->right)
+	{
+		node = ptr;
+		ptr = ptr->parent;
+	}
+
+	return ptr;
+}
+
 template <typename TKey, typename TValue>
 void BST<TKey, TValue>::transplant(Node* prevNode, Node* newNode)
 {
@@ -0,0 +1,156 @@
+// ConcurrentMap.cpp : Defines the entry point for the console application.
+//
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "ConcurrentSkipList.h"
+#include "../RBTree/RBTree.h"
+
+using namespace std;
+
+// The single-mutex setup the skip list is meant to replace.
+class LockedRBTree
+{
+public:
+	bool contains(int key)
+	{
+		lock_guard<mutex> guard(lock);
+		return tree.contains(key);
+	}
+
+	bool insert(int key, int value)
+	{
+		lock_guard<mutex> guard(lock);
+		if (tree.contains(key))
+			return false;
+
+		tree.insert(key, value);
+		return true;
+	}
+
+	bool remove(int key)
+	{
+		lock_guard<mutex> guard(lock);
+		tree.remove(key);
+		return true;
+	}
+
+private:
+	mutex lock;
+	algs::RBTree<int, int> tree;
+};
+
+const int keyRange = 1 << 20;
+const chrono::milliseconds runTime(500);
+
+// Runs a fixed-time read/write mix and returns throughput in operations per second.
+// Updates are split evenly between insert and remove so the size stays near keyRange / 2.
+template <typename TMap>
+double runMix(TMap& map, unsigned threadCount, unsigned readPercent)
+{
+	atomic<bool> start(false);
+	atomic<bool> stop(false);
+	vector<unsigned long long> counts(threadCount);
+	vector<unsigned long long> hits(threadCount);
+	vector<thread> threads;
+
+	for (unsigned t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&, t]()
+		{
+			mt19937 rng(t + 1);
+			uniform_int_distribution<int> keys(0, keyRange - 1);
+			uniform_int_distribution<unsigned> percent(0, 99);
+			unsigned long long ops = 0;
+			unsigned long long found = 0;
+
+			while (!start.load()) { }
+
+			while (!stop.load(memory_order_relaxed))
+			{
+				int key = keys(rng);
+				unsigned dice = percent(rng);
+
+				if (dice < readPercent)
+					found += map.contains(key);
+				else if ((dice - readPercent) % 2 == 0)
+					map.insert(key, key);
+				else
+					map.remove(key);
+
+				ops++;
+			}
+
+			counts[t] = ops;
+			hits[t] = found;
+		});
+	}
+
+	start.store(true);
+	this_thread::sleep_for(runTime);
+	stop.store(true);
+
+	for (auto& th : threads)
+		th.join();
+
+	unsigned long long total = 0;
+	for (auto count : counts)
+		total += count;
+
+	return total / chrono::duration<double>(runTime).count();
+}
+
+template <typename TMap>
+void prefill(TMap& map)
+{
+	for (int key = 0; key < keyRange; key += 2)
+		map.insert(key, key);
+}
+
+int main()
+{
+	algs::ConcurrentSkipList<int, int> list;
+	for (int x = 10; x > 0; x--)
+		list.insert(x, x);
+	list.remove(5);
+	list.print();
+	cout << endl;
+	cout << "Min " << list.min().first << " Max " << list.max().first
+		<< " Succ 4 " << list.successor(4) << " Pred 6 " << list.predecessor(6) << endl;
+
+	// Rows with more threads than the hardware runs at once measure oversubscription,
+	// not scaling: compare the two maps on a machine with at least as many cores.
+	const unsigned threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+	const unsigned readPercents[] = { 100, 90, 50 };
+
+	cout << endl << "Mops/s, " << keyRange << " keys, " << thread::hardware_concurrency() << " hardware threads" << endl;
+	cout << setw(8) << "threads" << setw(8) << "reads" << setw(14) << "skiplist" << setw(14) << "locked RB" << endl;
+
+	for (auto readPercent : readPercents)
+	{
+		for (auto threadCount : threadCounts)
+		{
+			algs::ConcurrentSkipList<int, int> skipList;
+			LockedRBTree rbTree;
+			prefill(skipList);
+			prefill(rbTree);
+
+			double skipListOps = runMix(skipList, threadCount, readPercent);
+			double rbTreeOps = runMix(rbTree, threadCount, readPercent);
+
+			cout << setw(8) << threadCount << setw(7) << readPercent << "%"
+				<< setw(14) << fixed << setprecision(2) << skipListOps / 1e6
+				<< setw(14) << rbTreeOps / 1e6 << endl;
+		}
+	}
+
+	return 0;
+}
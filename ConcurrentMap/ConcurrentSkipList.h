@@ -0,0 +1,511 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <utility>
+#include "EpochManager.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define ALGS_SKIPLIST_PAUSE
+#include <immintrin.h>
+#endif
+
+namespace algs {
+
+	namespace detail {
+
+		// One step of a busy wait: a pause hint for the first spins, which frees the
+		// core for its hyper-thread sibling, then yielding so that a preempted lock
+		// holder gets to run.
+		class SpinBackoff
+		{
+		public:
+			SpinBackoff() : spins(0) { }
+
+			void wait()
+			{
+				if (spins < yieldAfter)
+				{
+					spins++;
+#ifdef ALGS_SKIPLIST_PAUSE
+					_mm_pause();
+#endif
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+
+		private:
+			static constexpr int yieldAfter = 64;
+
+			int spins;
+		};
+	}
+
+	// Concurrent ordered map built on the lazy skip list of Herlihy, Lev, Luchangco and Shavit.
+	// find/successor/predecessor never lock or write shared memory; insert and remove lock
+	// only the predecessors of the affected node and validate them before linking.
+	// Removed nodes are reclaimed through an EpochManager.
+	//
+	// Keys are unique and values immutable once inserted, so lookups return copies:
+	// a reference could outlive the node it points to.
+	template <
+		typename TKey,
+		typename TValue,
+		typename TComp = std::less<TKey>
+	>
+	class ConcurrentSkipList
+	{
+		static constexpr int maxLevel = 32;
+
+		class SpinLock
+		{
+		public:
+			SpinLock() : flag(false) { }
+
+			void lock()
+			{
+				detail::SpinBackoff backoff;
+
+				while (flag.exchange(true, std::memory_order_acquire))
+				{
+					while (flag.load(std::memory_order_relaxed))
+						backoff.wait();
+				}
+			}
+
+			void unlock()
+			{
+				flag.store(false, std::memory_order_release);
+			}
+
+		private:
+			std::atomic<bool> flag;
+		};
+
+		struct Node
+		{
+			std::pair<TKey, TValue> keyValue;
+
+			int topLevel;
+			std::atomic<bool> marked;
+			std::atomic<bool> fullyLinked;
+			SpinLock lock;
+
+			// Tower of topLevel + 1 forward pointers, allocated together with the node.
+			std::atomic<Node*> next[1];
+
+			const TKey& key() const { return keyValue.first; }
+
+			const TValue& value() const { return keyValue.second; }
+
+			static Node* create(const TKey& key, const TValue& value, int topLevel)
+			{
+				void* memory = ::operator new(sizeof(Node) + topLevel * sizeof(std::atomic<Node*>));
+				return new (memory) Node(key, value, topLevel);
+			}
+
+			static void destroy(void* ptr)
+			{
+				Node* node = static_cast<Node*>(ptr);
+				node->~Node();
+				::operator delete(node);
+			}
+
+		private:
+			Node(const TKey& key, const TValue& value, int topLevel) :
+				keyValue(key, value),
+				topLevel(topLevel),
+				marked(false),
+				fullyLinked(false)
+			{
+				for (int level = 0; level <= topLevel; ++level)
+					new (&next[level]) std::atomic<Node*>(nullptr);
+			}
+		};
+
+	public:
+		explicit ConcurrentSkipList() :
+			comp(),
+			head(Node::create(TKey(), TValue(), maxLevel - 1))
+		{
+		}
+
+		explicit ConcurrentSkipList(const TComp& comp) :
+			comp(comp),
+			head(Node::create(TKey(), TValue(), maxLevel - 1))
+		{
+		}
+
+		~ConcurrentSkipList()
+		{
+			Node* node = head;
+			while (node != nullptr)
+			{
+				Node* next = node->next[0].load(std::memory_order_relaxed);
+				Node::destroy(node);
+				node = next;
+			}
+		}
+
+		ConcurrentSkipList(const ConcurrentSkipList&) = delete;
+		ConcurrentSkipList& operator=(const ConcurrentSkipList&) = delete;
+
+		TValue find(const TKey& key) const;
+
+		bool contains(const TKey& key) const;
+
+		std::pair<TKey, TValue> min() const;
+
+		std::pair<TKey, TValue> max() const;
+
+		TKey successor(const TKey& key) const;
+
+		TKey predecessor(const TKey& key) const;
+
+		// Returns false if the key is already present.
+		bool insert(const TKey& key, const TValue& value);
+
+		// Returns false if the key is not present.
+		bool remove(const TKey& key);
+
+		// Not linearizable with respect to concurrent updates.
+		void print() const
+		{
+			EpochManager::Guard guard(epochs);
+
+			for (Node* node = head->next[0].load(); node != nullptr; node = node->next[0].load())
+			{
+				if (isLive(node))
+					std::cout << node->key() << " (" << node->value() << ") ";
+			}
+		}
+
+	private:
+		static bool isLive(const Node* node)
+		{
+			return node->fullyLinked.load(std::memory_order_acquire) && !node->marked.load(std::memory_order_acquire);
+		}
+
+		// Fills preds/succs around key on every level and returns the highest
+		// level on which a node with this key was found, or -1.
+		int findNode(const TKey& key, Node** preds, Node** succs) const;
+
+		// The bottom-level neighbour of a search may be in the middle of removal;
+		// search again below its key until a live node or the head is reached.
+		Node* livePredecessor(Node* node, Node** preds, Node** succs) const
+		{
+			while (node != head && !isLive(node))
+			{
+				findNode(node->key(), preds, succs);
+				node = preds[0];
+			}
+
+			return node;
+		}
+
+		static int randomLevel();
+
+		static void unlock(Node** preds, int highestLocked)
+		{
+			for (int level = 0; level <= highestLocked; ++level)
+			{
+				if (level == 0 || preds[level] != preds[level - 1])
+					preds[level]->lock.unlock();
+			}
+		}
+
+	private:
+		TComp comp;
+		Node* head;
+		mutable EpochManager epochs;
+	};
+
+	template <typename TKey, typename TValue, typename TComp>
+	int ConcurrentSkipList<TKey, TValue, TComp>::findNode(const TKey& key, Node** preds, Node** succs) const
+	{
+		int levelFound = -1;
+		Node* pred = head;
+
+		for (int level = maxLevel - 1; level >= 0; --level)
+		{
+			Node* current = pred->next[level].load(std::memory_order_acquire);
+
+			while (current != nullptr && comp(current->key(), key))
+			{
+				pred = current;
+				current = pred->next[level].load(std::memory_order_acquire);
+			}
+
+			if (levelFound == -1 && current != nullptr && !comp(key, current->key()))
+				levelFound = level;
+
+			preds[level] = pred;
+			succs[level] = current;
+		}
+
+		return levelFound;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	int ConcurrentSkipList<TKey, TValue, TComp>::randomLevel()
+	{
+		// Geometric distribution with p = 1/2 from the trailing one bits of a per-thread xorshift.
+		thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^ (reinterpret_cast<uintptr_t>(&state) * 0xBF58476D1CE4E5B9ull);
+
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+
+		uint64_t bits = state;
+		int level = 0;
+		while ((bits & 1) != 0 && level < maxLevel - 1)
+		{
+			level++;
+			bits >>= 1;
+		}
+
+		return level;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	TValue ConcurrentSkipList<TKey, TValue, TComp>::find(const TKey& key) const
+	{
+		EpochManager::Guard guard(epochs);
+
+		Node* preds[maxLevel];
+		Node* succs[maxLevel];
+
+		int levelFound = findNode(key, preds, succs);
+		if (levelFound == -1 || !isLive(succs[levelFound]))
+			throw std::exception("Cannot find node");
+
+		return succs[levelFound]->value();
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	bool ConcurrentSkipList<TKey, TValue, TComp>::contains(const TKey& key) const
+	{
+		EpochManager::Guard guard(epochs);
+
+		Node* preds[maxLevel];
+		Node* succs[maxLevel];
+
+		int levelFound = findNode(key, preds, succs);
+		return levelFound != -1 && isLive(succs[levelFound]);
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	std::pair<TKey, TValue> ConcurrentSkipList<TKey, TValue, TComp>::min() const
+	{
+		EpochManager::Guard guard(epochs);
+
+		Node* node = head->next[0].load(std::memory_order_acquire);
+		while (node != nullptr && !isLive(node))
+			node = node->next[0].load(std::memory_order_acquire);
+
+		if (node == nullptr)
+			throw std::exception("Cannot find node");
+
+		return node->keyValue;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	std::pair<TKey, TValue> ConcurrentSkipList<TKey, TValue, TComp>::max() const
+	{
+		EpochManager::Guard guard(epochs);
+
+		Node* preds[maxLevel];
+		Node* succs[maxLevel];
+
+		// Run to the right end of every level, then step back over nodes that are being removed.
+		Node* node = head;
+		for (int level = maxLevel - 1; level >= 0; --level)
+		{
+			Node* current = node->next[level].load(std::memory_order_acquire);
+			while (current != nullptr)
+			{
+				node = current;
+				current = node->next[level].load(std::memory_order_acquire);
+			}
+		}
+
+		node = livePredecessor(node, preds, succs);
+		if (node == head)
+			throw std::exception("Cannot find node");
+
+		return node->keyValue;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	TKey ConcurrentSkipList<TKey, TValue, TComp>::successor(const TKey& key) const
+	{
+		EpochManager::Guard guard(epochs);
+
+		Node* preds[maxLevel];
+		Node* succs[maxLevel];
+
+		findNode(key, preds, succs);
+
+		Node* node = succs[0];
+		while (node != nullptr && (!isLive(node) || !comp(key, node->key())))
+			node = node->next[0].load(std::memory_order_acquire);
+
+		if (node == nullptr)
+			throw std::exception("Cannot find successor");
+
+		return node->key();
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	TKey ConcurrentSkipList<TKey, TValue, TComp>::predecessor(const TKey& key) const
+	{
+		EpochManager::Guard guard(epochs);
+
+		Node* preds[maxLevel];
+		Node* succs[maxLevel];
+
+		findNode(key, preds, succs);
+		Node* node = livePredecessor(preds[0], preds, succs);
+
+		if (node == head)
+			throw std::exception("Cannot find predecessor");
+
+		return node->key();
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	bool ConcurrentSkipList<TKey, TValue, TComp>::insert(const TKey& key, const TValue& value)
+	{
+		EpochManager::Guard guard(epochs);
+
+		int topLevel = randomLevel();
+		Node* preds[maxLevel];
+		Node* succs[maxLevel];
+
+		while (true)
+		{
+			int levelFound = findNode(key, preds, succs);
+			if (levelFound != -1)
+			{
+				Node* found = succs[levelFound];
+				if (!found->marked.load(std::memory_order_acquire))
+				{
+					detail::SpinBackoff backoff;
+					while (!found->fullyLinked.load(std::memory_order_acquire))
+						backoff.wait();
+					return false;
+				}
+
+				// Found node is being removed; retry once it is unlinked.
+				continue;
+			}
+
+			int highestLocked = -1;
+			bool valid = true;
+			for (int level = 0; valid && level <= topLevel; ++level)
+			{
+				Node* pred = preds[level];
+				Node* succ = succs[level];
+
+				if (level == 0 || pred != preds[level - 1])
+					pred->lock.lock();
+				highestLocked = level;
+
+				valid = !pred->marked.load(std::memory_order_acquire) &&
+					(succ == nullptr || !succ->marked.load(std::memory_order_acquire)) &&
+					pred->next[level].load(std::memory_order_acquire) == succ;
+			}
+
+			if (!valid)
+			{
+				unlock(preds, highestLocked);
+				continue;
+			}
+
+			Node* newNode = Node::create(key, value, topLevel);
+			for (int level = 0; level <= topLevel; ++level)
+				newNode->next[level].store(succs[level], std::memory_order_relaxed);
+
+			for (int level = 0; level <= topLevel; ++level)
+				preds[level]->next[level].store(newNode, std::memory_order_release);
+
+			newNode->fullyLinked.store(true, std::memory_order_release);
+			unlock(preds, highestLocked);
+			return true;
+		}
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	bool ConcurrentSkipList<TKey, TValue, TComp>::remove(const TKey& key)
+	{
+		EpochManager::Guard guard(epochs);
+
+		Node* victim = nullptr;
+		bool isMarked = false;
+		int topLevel = -1;
+		Node* preds[maxLevel];
+		Node* succs[maxLevel];
+
+		while (true)
+		{
+			int levelFound = findNode(key, preds, succs);
+			if (levelFound != -1)
+				victim = succs[levelFound];
+
+			if (!isMarked && (levelFound == -1 || !isLive(victim) || victim->topLevel != levelFound))
+				return false;
+
+			if (!isMarked)
+			{
+				topLevel = victim->topLevel;
+				victim->lock.lock();
+				if (victim->marked.load(std::memory_order_acquire))
+				{
+					victim->lock.unlock();
+					return false;
+				}
+
+				// Logical removal: from here on the node is invisible to readers.
+				victim->marked.store(true, std::memory_order_release);
+				isMarked = true;
+			}
+
+			int highestLocked = -1;
+			bool valid = true;
+			for (int level = 0; valid && level <= topLevel; ++level)
+			{
+				Node* pred = preds[level];
+
+				if (level == 0 || pred != preds[level - 1])
+					pred->lock.lock();
+				highestLocked = level;
+
+				valid = !pred->marked.load(std::memory_order_acquire) &&
+					pred->next[level].load(std::memory_order_acquire) == victim;
+			}
+
+			if (!valid)
+			{
+				unlock(preds, highestLocked);
+				continue;
+			}
+
+			for (int level = topLevel; level >= 0; --level)
+				preds[level]->next[level].store(victim->next[level].load(std::memory_order_relaxed), std::memory_order_release);
+
+			victim->lock.unlock();
+			unlock(preds, highestLocked);
+
+			epochs.retire(victim, &Node::destroy);
+			return true;
+		}
+	}
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+namespace algs {
+
+	// Small process-wide registry that hands every thread a dense index,
+	// recycled when the thread exits, so per-thread state can live in flat arrays.
+	class ThreadRegistry
+	{
+	public:
+		static constexpr size_t maxThreads = 256;
+
+		static size_t index()
+		{
+			thread_local Registration registration;
+			return registration.index;
+		}
+
+	private:
+		struct Registration
+		{
+			size_t index;
+
+			Registration() : index(acquire()) { }
+
+			~Registration() { release(index); }
+		};
+
+		static std::mutex& lock()
+		{
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		static std::vector<size_t>& freeList()
+		{
+			static std::vector<size_t> list;
+			return list;
+		}
+
+		static size_t acquire()
+		{
+			static size_t next = 0;
+
+			std::lock_guard<std::mutex> guard(lock());
+			if (!freeList().empty())
+			{
+				size_t index = freeList().back();
+				freeList().pop_back();
+				return index;
+			}
+
+			if (next == maxThreads)
+				throw std::exception("Too many threads");
+
+			return next++;
+		}
+
+		static void release(size_t index)
+		{
+			std::lock_guard<std::mutex> guard(lock());
+			freeList().push_back(index);
+		}
+	};
+
+	// Epoch-based memory reclamation.
+	// Readers pin the current epoch for the duration of an operation; retired
+	// objects are freed once the global epoch has advanced twice past the epoch
+	// they were retired in, i.e. once no pinned thread can still reference them.
+	class EpochManager
+	{
+		static constexpr size_t collectThreshold = 64;
+
+	public:
+		class Guard
+		{
+		public:
+			explicit Guard(EpochManager& manager) : manager(manager)
+			{
+				manager.enter();
+			}
+
+			~Guard()
+			{
+				manager.leave();
+			}
+
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+
+		private:
+			EpochManager& manager;
+		};
+
+		EpochManager() : globalEpoch(2) { }
+
+		~EpochManager()
+		{
+			for (auto& slot : slots)
+			{
+				for (auto& item : slot.retired)
+					item.deleter(item.ptr);
+			}
+		}
+
+		EpochManager(const EpochManager&) = delete;
+		EpochManager& operator=(const EpochManager&) = delete;
+
+		// Must be called after ptr has been unlinked from the shared structure.
+		void retire(void* ptr, void(*deleter)(void*))
+		{
+			Slot& slot = slots[ThreadRegistry::index()];
+
+			slot.retired.push_back({ ptr, deleter, globalEpoch.load(std::memory_order_seq_cst) });
+
+			if (slot.retired.size() >= slot.collectAt)
+			{
+				tryAdvance();
+				collect(slot);
+				slot.collectAt = slot.retired.size() + collectThreshold;
+			}
+		}
+
+	private:
+		struct Retired
+		{
+			void* ptr;
+			void(*deleter)(void*);
+			uint64_t epoch;
+		};
+
+		// One cache line per thread. state is 0 when the thread is outside
+		// any operation, otherwise (epoch << 1) | 1.
+		struct alignas(64) Slot
+		{
+			std::atomic<uint64_t> state;
+			unsigned depth;
+			size_t collectAt;
+			std::vector<Retired> retired;
+
+			Slot() : state(0), depth(0), collectAt(collectThreshold) { }
+		};
+
+		void enter()
+		{
+			Slot& slot = slots[ThreadRegistry::index()];
+			if (slot.depth++ > 0)
+				return;
+
+			uint64_t epoch = globalEpoch.load(std::memory_order_relaxed);
+			while (true)
+			{
+				slot.state.store((epoch << 1) | 1, std::memory_order_seq_cst);
+
+				uint64_t current = globalEpoch.load(std::memory_order_seq_cst);
+				if (current == epoch)
+					break;
+				epoch = current;
+			}
+		}
+
+		void leave()
+		{
+			Slot& slot = slots[ThreadRegistry::index()];
+			if (--slot.depth == 0)
+				slot.state.store(0, std::memory_order_release);
+		}
+
+		void tryAdvance()
+		{
+			uint64_t epoch = globalEpoch.load(std::memory_order_seq_cst);
+
+			for (const auto& slot : slots)
+			{
+				uint64_t state = slot.state.load(std::memory_order_seq_cst);
+				if ((state & 1) != 0 && (state >> 1) != epoch)
+					return;
+			}
+
+			globalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+		}
+
+		void collect(Slot& slot)
+		{
+			uint64_t epoch = globalEpoch.load(std::memory_order_seq_cst);
+
+			size_t kept = 0;
+			for (size_t i = 0; i < slot.retired.size(); ++i)
+			{
+				Retired& item = slot.retired[i];
+				if (item.epoch + 2 <= epoch)
+					item.deleter(item.ptr);
+				else
+					slot.retired[kept++] = item;
+			}
+			slot.retired.resize(kept);
+		}
+
+	private:
+		std::atomic<uint64_t> globalEpoch;
+		Slot slots[ThreadRegistry::maxThreads];
+	};
+}
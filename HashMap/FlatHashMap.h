@@ -0,0 +1,395 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ALGS_HASHMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace algs {
+
+	// Unordered map with open addressing in the style of SwissTable (Abseil's flat_hash_map).
+	// Every slot has a control byte: empty, deleted, or the low 7 bits of the key's hash.
+	// Slots are probed in aligned groups of 16, and one SSE2 compare checks the 7-bit tag of
+	// a whole group, so most lookups touch one cache line of control bytes and compare a
+	// single key. Entries live in one flat array, with no node per entry.
+	//
+	// Same interface as the trees for the point operations: find, contains, insert, remove,
+	// with the hasher as a template parameter in place of the comparator. Keys are unique:
+	// inserting a present key replaces its value. No ordering, so no min/max/successor.
+	// Inserts may move the entries: references returned by find() are valid until the
+	// next insert.
+	template <
+		typename TKey,
+		typename TValue,
+		typename THash = std::hash<TKey>,
+		typename TEqual = std::equal_to<TKey>
+	>
+	class FlatHashMap
+	{
+		typedef std::pair<TKey, TValue> Slot;
+
+		static constexpr size_t groupWidth = 16;
+
+		static constexpr size_t notFound = ~size_t(0);
+
+		// Control bytes. Full slots hold a value in [0, 127].
+		static constexpr int8_t emptyControl = -128;
+		static constexpr int8_t deletedControl = -2;
+
+		// Bit i is set for byte i of a group.
+		typedef uint32_t GroupMask;
+
+	public:
+		explicit FlatHashMap() :
+			hasher(),
+			equal(),
+			control(nullptr),
+			slots(nullptr),
+			capacity(0),
+			count(0),
+			growthLeft(0)
+		{
+		}
+
+		explicit FlatHashMap(const THash& hasher, const TEqual& equal = TEqual()) :
+			hasher(hasher),
+			equal(equal),
+			control(nullptr),
+			slots(nullptr),
+			capacity(0),
+			count(0),
+			growthLeft(0)
+		{
+		}
+
+		FlatHashMap(const FlatHashMap&) = delete;
+		FlatHashMap& operator=(const FlatHashMap&) = delete;
+
+		~FlatHashMap()
+		{
+			release();
+		}
+
+		const TValue& find(const TKey& key) const
+		{
+			size_t index = findIndex(key);
+
+			if (index == notFound)
+				throw std::exception("Cannot find key");
+
+			return slots[index].second;
+		}
+
+		bool contains(const TKey& key) const
+		{
+			return findIndex(key) != notFound;
+		}
+
+		void insert(const TKey& key, const TValue& value);
+
+		void remove(const TKey& key);
+
+		// Makes room for n entries in total, so inserts up to that size do not rehash.
+		void reserve(size_t n)
+		{
+			size_t needed = groupWidth;
+			while (needed * 7 / 8 < n)
+				needed *= 2;
+
+			if (needed > capacity)
+				rehash(needed);
+		}
+
+		void clear()
+		{
+			release();
+			count = 0;
+			capacity = 0;
+			growthLeft = 0;
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		bool empty() const
+		{
+			return count == 0;
+		}
+
+		size_t bucketCount() const
+		{
+			return capacity;
+		}
+
+		// Calls visit(key, value) for every entry, in no particular order.
+		template <typename TFunc>
+		void forEach(TFunc visit) const
+		{
+			for (size_t index = 0; index < capacity; index++)
+			{
+				if (control[index] >= 0)
+					visit(slots[index].first, slots[index].second);
+			}
+		}
+
+		void print() const
+		{
+			forEach([](const TKey& key, const TValue& value)
+			{
+				std::cout << key << " (" << value << ") ";
+			});
+		}
+
+	private:
+		// Spreads the hasher's output over all bits: std::hash of an integer is often
+		// the identity, whose low bits alone would make poor tags and group indices.
+		size_t hashOf(const TKey& key) const
+		{
+			uint64_t hash = static_cast<uint64_t>(hasher(key));
+			hash ^= hash >> 33;
+			hash *= 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 33;
+			return static_cast<size_t>(hash);
+		}
+
+		static int8_t tagOf(size_t hash)
+		{
+			return static_cast<int8_t>(hash & 0x7F);
+		}
+
+		// Group to start probing from, out of capacity / groupWidth.
+		size_t firstGroup(size_t hash) const
+		{
+			return (hash >> 7) & (capacity / groupWidth - 1);
+		}
+
+		static GroupMask match(const int8_t* group, int8_t tag)
+		{
+#ifdef ALGS_HASHMAP_SSE2
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+			return static_cast<GroupMask>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(tag))));
+#else
+			GroupMask mask = 0;
+			for (size_t i = 0; i < groupWidth; i++)
+				mask |= static_cast<GroupMask>(group[i] == tag) << i;
+			return mask;
+#endif
+		}
+
+		// Empty or deleted slots: the only control bytes with the sign bit set.
+		static GroupMask matchFree(const int8_t* group)
+		{
+#ifdef ALGS_HASHMAP_SSE2
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+			return static_cast<GroupMask>(_mm_movemask_epi8(bytes));
+#else
+			GroupMask mask = 0;
+			for (size_t i = 0; i < groupWidth; i++)
+				mask |= static_cast<GroupMask>(group[i] < 0) << i;
+			return mask;
+#endif
+		}
+
+		static size_t lowestBit(GroupMask mask)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return index;
+#else
+			return static_cast<size_t>(__builtin_ctz(mask));
+#endif
+		}
+
+		size_t findIndex(const TKey& key) const;
+
+		// First empty or deleted slot on the probe sequence of hash.
+		size_t findFree(size_t hash) const;
+
+		void rehash(size_t newCapacity);
+
+		void release();
+
+	private:
+		THash hasher;
+		TEqual equal;
+
+		// capacity control bytes, then the slots. Capacity is 0 or a power of two
+		// and a multiple of groupWidth.
+		int8_t* control;
+		Slot* slots;
+		size_t capacity;
+		size_t count;
+
+		// Empty slots that may still be filled before the table is rehashed: the table is
+		// kept at most 7/8 full, counting deleted slots, so every probe meets an empty slot.
+		size_t growthLeft;
+	};
+
+	template <typename TKey, typename TValue, typename THash, typename TEqual>
+	size_t FlatHashMap<TKey, TValue, THash, TEqual>::findIndex(const TKey& key) const
+	{
+		if (count == 0)
+			return notFound;
+
+		size_t hash = hashOf(key);
+		int8_t tag = tagOf(hash);
+		size_t groupMask = capacity / groupWidth - 1;
+		size_t group = firstGroup(hash);
+
+		// Triangular steps over the groups visit each of them once, as their number is a power of two.
+		for (size_t step = 1; ; step++)
+		{
+			const int8_t* groupControl = control + group * groupWidth;
+
+			for (GroupMask mask = match(groupControl, tag); mask != 0; mask &= mask - 1)
+			{
+				size_t index = group * groupWidth + lowestBit(mask);
+
+				if (equal(slots[index].first, key))
+					return index;
+			}
+
+			// A key is never stored past a group that had an empty slot when it was inserted.
+			if (match(groupControl, emptyControl) != 0)
+				return notFound;
+
+			group = (group + step) & groupMask;
+		}
+	}
+
+	template <typename TKey, typename TValue, typename THash, typename TEqual>
+	size_t FlatHashMap<TKey, TValue, THash, TEqual>::findFree(size_t hash) const
+	{
+		size_t groupMask = capacity / groupWidth - 1;
+		size_t group = firstGroup(hash);
+
+		for (size_t step = 1; ; step++)
+		{
+			GroupMask mask = matchFree(control + group * groupWidth);
+
+			if (mask != 0)
+				return group * groupWidth + lowestBit(mask);
+
+			group = (group + step) & groupMask;
+		}
+	}
+
+	template <typename TKey, typename TValue, typename THash, typename TEqual>
+	void FlatHashMap<TKey, TValue, THash, TEqual>::insert(const TKey& key, const TValue& value)
+	{
+		size_t index = findIndex(key);
+
+		if (index != notFound)
+		{
+			slots[index].second = value;
+			return;
+		}
+
+		size_t hash = hashOf(key);
+		index = capacity == 0 ? notFound : findFree(hash);
+
+		// Reusing a deleted slot costs no growth; taking an empty one may need room first.
+		if (index == notFound || (growthLeft == 0 && control[index] == emptyControl))
+		{
+			// At most half full without the deleted slots: rehash in place to drop them.
+			// Otherwise double.
+			rehash(capacity == 0 ? groupWidth : count < capacity * 7 / 16 ? capacity : capacity * 2);
+			index = findFree(hash);
+		}
+
+		if (control[index] == emptyControl)
+			growthLeft--;
+
+		new (&slots[index]) Slot(key, value);
+		control[index] = tagOf(hash);
+		count++;
+	}
+
+	template <typename TKey, typename TValue, typename THash, typename TEqual>
+	void FlatHashMap<TKey, TValue, THash, TEqual>::remove(const TKey& key)
+	{
+		size_t index = findIndex(key);
+
+		if (index == notFound)
+			return;
+
+		slots[index].~Slot();
+		count--;
+
+		// Lookups stop at a group with an empty slot, so none of them ever went past this
+		// group if it has one: the slot can become empty again instead of a tombstone.
+		const int8_t* groupControl = control + index / groupWidth * groupWidth;
+
+		if (match(groupControl, emptyControl) != 0)
+		{
+			control[index] = emptyControl;
+			growthLeft++;
+		}
+		else
+		{
+			control[index] = deletedControl;
+		}
+	}
+
+	template <typename TKey, typename TValue, typename THash, typename TEqual>
+	void FlatHashMap<TKey, TValue, THash, TEqual>::rehash(size_t newCapacity)
+	{
+		int8_t* oldControl = control;
+		Slot* oldSlots = slots;
+		size_t oldCapacity = capacity;
+
+		// One allocation for the control bytes and the slots behind them.
+		size_t slotsOffset = (newCapacity + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+		char* memory = static_cast<char*>(::operator new(slotsOffset + newCapacity * sizeof(Slot)));
+
+		control = reinterpret_cast<int8_t*>(memory);
+		slots = reinterpret_cast<Slot*>(memory + slotsOffset);
+		capacity = newCapacity;
+		growthLeft = newCapacity * 7 / 8 - count;
+		std::memset(control, emptyControl, newCapacity);
+
+		for (size_t index = 0; index < oldCapacity; index++)
+		{
+			if (oldControl[index] < 0)
+				continue;
+
+			size_t hash = hashOf(oldSlots[index].first);
+			size_t target = findFree(hash);
+
+			new (&slots[target]) Slot(std::move(oldSlots[index]));
+			control[target] = tagOf(hash);
+			oldSlots[index].~Slot();
+		}
+
+		::operator delete(oldControl);
+	}
+
+	template <typename TKey, typename TValue, typename THash, typename TEqual>
+	void FlatHashMap<TKey, TValue, THash, TEqual>::release()
+	{
+		for (size_t index = 0; index < capacity; index++)
+		{
+			if (control[index] >= 0)
+				slots[index].~Slot();
+		}
+
+		::operator delete(control);
+		control = nullptr;
+		slots = nullptr;
+	}
+}
@@ -0,0 +1,127 @@
+// HashMap.cpp : Defines the entry point for the console application.
+//
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "FlatHashMap.h"
+#include "../RBTree/RBTree.h"
+
+using namespace std;
+
+// std::unordered_map with the insert/remove/contains names of the algs containers.
+class StdHashMap
+{
+public:
+	void insert(int key, int value)
+	{
+		map[key] = value;
+	}
+
+	void remove(int key)
+	{
+		map.erase(key);
+	}
+
+	bool contains(int key) const
+	{
+		return map.count(key) != 0;
+	}
+
+private:
+	unordered_map<int, int> map;
+};
+
+template <typename TFunc>
+double nanosecondsPerOp(size_t ops, TFunc run)
+{
+	auto start = chrono::steady_clock::now();
+	run();
+	chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+	return elapsed.count() / ops;
+}
+
+// Inserts keys, looks all of them up, looks up as many absent keys, then removes
+// everything. Prints nanoseconds per operation for each phase.
+template <typename TMap>
+void measure(const string& name, const vector<int>& keys, const vector<int>& misses)
+{
+	TMap map;
+	size_t found = 0;
+
+	double insert = nanosecondsPerOp(keys.size(), [&]()
+	{
+		for (int key : keys)
+			map.insert(key, key);
+	});
+
+	double hit = nanosecondsPerOp(keys.size(), [&]()
+	{
+		for (int key : keys)
+			found += map.contains(key);
+	});
+
+	double miss = nanosecondsPerOp(misses.size(), [&]()
+	{
+		for (int key : misses)
+			found += map.contains(key);
+	});
+
+	double remove = nanosecondsPerOp(keys.size(), [&]()
+	{
+		for (int key : keys)
+			map.remove(key);
+	});
+
+	if (found != keys.size())
+		cout << "Unexpected lookup results" << endl;
+
+	cout << setw(16) << name << fixed << setprecision(1)
+		<< setw(10) << insert << setw(10) << hit << setw(10) << miss << setw(10) << remove << endl;
+	cout.unsetf(ios_base::fixed);
+}
+
+int main()
+{
+	algs::FlatHashMap<string, int> colors;
+	colors.insert("red", 1);
+	colors.insert("black", 2);
+	colors.insert("red", 3);
+	colors.remove("black");
+	colors.print();
+	cout << endl << "Size " << colors.size() << ", contains black " << colors.contains("black") << endl;
+
+	mt19937 rng(1);
+
+	for (int n : { 1 << 10, 1 << 16, 1 << 20 })
+	{
+		// Even keys are stored and odd keys miss, both in random order.
+		vector<int> keys(n);
+		vector<int> misses(n);
+		for (int i = 0; i < n; i++)
+		{
+			keys[i] = 2 * i;
+			misses[i] = 2 * i + 1;
+		}
+
+		shuffle(keys.begin(), keys.end(), rng);
+		shuffle(misses.begin(), misses.end(), rng);
+
+		cout << endl << "ns/op, " << n << " int keys" << endl;
+		cout << setw(16) << "" << setw(10) << "insert" << setw(10) << "hit" << setw(10) << "miss" << setw(10) << "remove" << endl;
+
+		measure<algs::FlatHashMap<int, int>>("FlatHashMap", keys, misses);
+		measure<StdHashMap>("unordered_map", keys, misses);
+		measure<algs::RBTree<int, int>>("RBTree", keys, misses);
+	}
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+// LsmStore.cpp : Defines the entry point for the console application.
+//
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "LsmStore.h"
+#include "../RBTree/RBTree.h"
+
+using namespace std;
+
+template <typename TFunc>
+double millionOpsPerSecond(size_t ops, TFunc run)
+{
+	auto start = chrono::steady_clock::now();
+	run();
+	chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+	return ops / elapsed.count();
+}
+
+// Inserts keys, looks up as many random present keys, and scans rangeLength
+// keys from as many random starting points. Prints Mops/s for each phase.
+template <typename TMap, typename TScan>
+void measure(const string& name, TMap& map, const vector<int>& keys, const vector<int>& lookups, int rangeLength, TScan scan)
+{
+	size_t found = 0;
+	size_t scanned = 0;
+
+	double insert = millionOpsPerSecond(keys.size(), [&]()
+	{
+		for (int key : keys)
+			map.insert(key, key);
+	});
+
+	double lookup = millionOpsPerSecond(lookups.size(), [&]()
+	{
+		for (int key : lookups)
+			found += map.contains(key);
+	});
+
+	double range = millionOpsPerSecond(lookups.size() / 10, [&]()
+	{
+		for (size_t i = 0; i < lookups.size() / 10; i++)
+			scanned += scan(lookups[i], lookups[i] + rangeLength);
+	});
+
+	if (found != lookups.size())
+		cout << "Unexpected lookup results" << endl;
+
+	cout << setw(10) << name << fixed << setprecision(2)
+		<< setw(10) << insert << setw(10) << lookup << setw(10) << range
+		<< setw(14) << static_cast<double>(scanned) / (lookups.size() / 10) << endl;
+	cout.unsetf(ios_base::fixed);
+}
+
+int main()
+{
+	algs::LsmStore<string, int> colors(4);
+	colors.insert("red", 1);
+	colors.insert("green", 2);
+	colors.insert("blue", 3);
+	colors.insert("black", 4);
+	colors.insert("red", 5);
+	colors.remove("green");
+	colors.insert("white", 6);
+	colors.waitForCompaction();
+
+	colors.scan("a", "z", [](const string& key, int value)
+	{
+		cout << key << " (" << value << ") ";
+	});
+	cout << endl << "red " << colors.find("red") << ", contains green " << colors.contains("green")
+		<< ", runs " << colors.runCount() << endl;
+
+	mt19937 rng(1);
+
+	for (int n : { 1 << 16, 1 << 20 })
+	{
+		// Even keys in random order, so a range of 20 holds about 10 of them.
+		vector<int> keys(n);
+		for (int i = 0; i < n; i++)
+			keys[i] = 2 * i;
+
+		shuffle(keys.begin(), keys.end(), rng);
+
+		vector<int> lookups(keys);
+		shuffle(lookups.begin(), lookups.end(), rng);
+
+		cout << endl << "Mops/s, " << n << " int keys" << endl;
+		cout << setw(10) << "" << setw(10) << "insert" << setw(10) << "lookup" << setw(10) << "scan"
+			<< setw(14) << "keys/scan" << endl;
+
+		algs::RBTree<int, int> tree;
+		measure("RBTree", tree, keys, lookups, 20, [&tree](int from, int to)
+		{
+			return tree.range(from, to, [](int, int) { });
+		});
+
+		algs::LsmStore<int, int> store;
+		measure("LsmStore", store, keys, lookups, 20, [&store](int from, int to)
+		{
+			return store.scan(from, to, [](int, int) { });
+		});
+
+		cout << "LsmStore runs: " << store.runCount() << ", stored entries: " << store.storedEntries() << endl;
+	}
+
+	return 0;
+}
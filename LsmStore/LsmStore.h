@@ -0,0 +1,457 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../RBTree/RBTree.h"
+#include "../Sorting/ParallelMerge.h"
+
+namespace algs {
+
+	// Ordered key/value store in the style of a log-structured merge tree. Writes go to a
+	// small RBTree, the memtable, which stays cache-resident however large the store grows.
+	// A full memtable is read out in key order into an immutable sorted run: one sequential
+	// write per entry and no rebalancing. A background thread merges runs of similar size
+	// with parallelMerge, so there are O(log n) runs, the newest first.
+	//
+	// Lookups search the memtable and then the runs from the newest, stopping at the first
+	// hit. A run keeps the first key of every block of fenceInterval entries in a separate
+	// array, small enough to stay in cache: a binary search over it picks the one block the
+	// key can be in, and only that block of entries is touched. Removes write a tombstone,
+	// dropped when a merge reaches the oldest run. Keys are unique: inserting a present key
+	// replaces its value.
+	//
+	// One thread at a time may call the store's methods; the compaction thread is internal.
+	template <
+		typename TKey,
+		typename TValue,
+		typename TComp = std::less<TKey>
+	>
+	class LsmStore
+	{
+		struct Slot
+		{
+			TValue value;
+			bool removed;
+		};
+
+		typedef std::pair<TKey, Slot> Entry;
+
+		typedef RBTree<TKey, Slot, TComp> Memtable;
+
+		struct SortedRun
+		{
+			std::vector<Entry> entries;
+
+			// fences[i] is the key of entries[i * fenceInterval].
+			std::vector<TKey> fences;
+		};
+
+		typedef std::shared_ptr<const SortedRun> RunPtr;
+
+		static constexpr size_t fenceInterval = 64;
+
+		// Flushes wait for the compaction thread beyond this many runs.
+		static constexpr size_t maxRuns = 24;
+
+	public:
+		explicit LsmStore(size_t memtableLimit = 1 << 16) :
+			comp(),
+			memtable(new Memtable(comp)),
+			memtableLimit(memtableLimit),
+			stopping(false),
+			merging(false),
+			compactor()
+		{
+			compactor = std::thread([this]() { compactLoop(); });
+		}
+
+		explicit LsmStore(const TComp& comp, size_t memtableLimit = 1 << 16) :
+			comp(comp),
+			memtable(new Memtable(comp)),
+			memtableLimit(memtableLimit),
+			stopping(false),
+			merging(false),
+			compactor()
+		{
+			compactor = std::thread([this]() { compactLoop(); });
+		}
+
+		LsmStore(const LsmStore&) = delete;
+		LsmStore& operator=(const LsmStore&) = delete;
+
+		~LsmStore()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+
+			changed.notify_all();
+			compactor.join();
+		}
+
+		// Returns a copy: compaction may free the run the value was found in.
+		TValue find(const TKey& key) const
+		{
+			Slot slot;
+
+			if (!lookup(key, slot) || slot.removed)
+				throw std::exception("Cannot find key");
+
+			return slot.value;
+		}
+
+		bool contains(const TKey& key) const
+		{
+			Slot slot;
+			return lookup(key, slot) && !slot.removed;
+		}
+
+		void insert(const TKey& key, const TValue& value)
+		{
+			write(key, Slot{ value, false });
+		}
+
+		void remove(const TKey& key)
+		{
+			write(key, Slot{ TValue(), true });
+		}
+
+		// Calls visit(key, value) for every entry with a key in [from, to), in key order,
+		// merging the memtable and all runs. Returns the number of entries visited.
+		template <typename TFunc>
+		size_t scan(const TKey& from, const TKey& to, TFunc visit) const;
+
+		// Turns the memtable into a sorted run, even if it is not full.
+		void flush();
+
+		// Blocks until the compaction thread has nothing left to merge.
+		void waitForCompaction()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [this]() { return !merging && findMerge() == runs.size(); });
+		}
+
+		size_t runCount() const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return runs.size();
+		}
+
+		// Entries in the memtable and the runs, counting overwritten values and tombstones
+		// that have not been merged away yet.
+		size_t storedEntries() const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			size_t stored = memtable->size();
+			for (const auto& run : runs)
+				stored += run->entries.size();
+
+			return stored;
+		}
+
+	private:
+		bool less(const Entry& left, const Entry& right) const
+		{
+			return comp(left.first, right.first);
+		}
+
+		// Copies the newest slot for key, a tombstone included, to slot. Returns false if
+		// there is none.
+		bool lookup(const TKey& key, Slot& slot) const;
+
+		// Slot for key in run, or nullptr.
+		const Slot* findInRun(const SortedRun& run, const TKey& key) const;
+
+		// Index of the first entry of run not below key.
+		size_t lowerBound(const SortedRun& run, const TKey& key) const;
+
+		void write(const TKey& key, const Slot& slot)
+		{
+			// The memtable keeps one slot per key.
+			memtable->insertOrAssign(key, slot);
+
+			if (memtable->size() >= memtableLimit)
+				flush();
+		}
+
+		static void addFences(SortedRun& run)
+		{
+			for (size_t i = 0; i < run.entries.size(); i += fenceInterval)
+				run.fences.push_back(run.entries[i].first);
+		}
+
+		// Index i of the pair of runs[i] and runs[i + 1] to merge next, runs.size() if
+		// none. Called with the mutex held.
+		size_t findMerge() const;
+
+		void compactLoop();
+
+		// Merges newer into older. Newer entries win, and tombstones are dropped when
+		// there is nothing older for them to hide.
+		RunPtr merge(const SortedRun& newer, const SortedRun& older, bool oldest) const;
+
+	private:
+		TComp comp;
+
+		// Only touched by the calling thread.
+		std::unique_ptr<Memtable> memtable;
+		size_t memtableLimit;
+
+		// Newest first. Guarded by mutex: the compaction thread replaces two neighbouring
+		// runs with their merge, flush() adds runs in front.
+		mutable std::mutex mutex;
+		std::condition_variable changed;
+		std::vector<RunPtr> runs;
+		bool stopping;
+		bool merging;
+
+		std::thread compactor;
+	};
+
+	template <typename TKey, typename TValue, typename TComp>
+	bool LsmStore<TKey, TValue, TComp>::lookup(const TKey& key, Slot& slot) const
+	{
+		const Slot* newest = memtable->tryFind(key);
+
+		if (newest != nullptr)
+		{
+			slot = *newest;
+			return true;
+		}
+
+		// Held while copying, as a merge may free the run the slot is in.
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (const auto& run : runs)
+		{
+			const Slot* found = findInRun(*run, key);
+
+			if (found != nullptr)
+			{
+				slot = *found;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	size_t LsmStore<TKey, TValue, TComp>::lowerBound(const SortedRun& run, const TKey& key) const
+	{
+		// Last block whose first key is not above key: the block key would be in.
+		auto fence = std::upper_bound(run.fences.begin(), run.fences.end(), key, comp);
+		if (fence == run.fences.begin())
+			return 0;
+
+		size_t block = static_cast<size_t>(fence - run.fences.begin()) - 1;
+		auto first = run.entries.begin() + block * fenceInterval;
+		auto last = run.entries.begin() + std::min(run.entries.size(), (block + 1) * fenceInterval);
+
+		auto found = std::lower_bound(first, last, key, [this](const Entry& entry, const TKey& key)
+		{
+			return comp(entry.first, key);
+		});
+
+		return static_cast<size_t>(found - run.entries.begin());
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	const typename LsmStore<TKey, TValue, TComp>::Slot*
+		LsmStore<TKey, TValue, TComp>::findInRun(const SortedRun& run, const TKey& key) const
+	{
+		if (run.fences.empty() || comp(key, run.fences.front()))
+			return nullptr;
+
+		size_t index = lowerBound(run, key);
+
+		if (index == run.entries.size() || comp(key, run.entries[index].first))
+			return nullptr;
+
+		return &run.entries[index].second;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	template <typename TFunc>
+	size_t LsmStore<TKey, TValue, TComp>::scan(const TKey& from, const TKey& to, TFunc visit) const
+	{
+		// Sources newest first: the memtable's part of the range, then the runs.
+		std::vector<Entry> fromMemtable;
+		memtable->range(from, to, [&fromMemtable](const TKey& key, const Slot& slot)
+		{
+			fromMemtable.push_back(Entry(key, slot));
+		});
+
+		std::vector<RunPtr> snapshot;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			snapshot = runs;
+		}
+
+		struct Cursor
+		{
+			const Entry* next;
+			const Entry* end;
+		};
+
+		std::vector<Cursor> cursors;
+		cursors.push_back(Cursor{ fromMemtable.data(), fromMemtable.data() + fromMemtable.size() });
+
+		for (const auto& run : snapshot)
+		{
+			const Entry* entries = run->entries.data();
+			cursors.push_back(Cursor{ entries + lowerBound(*run, from), entries + run->entries.size() });
+		}
+
+		// O(log n) sources: a linear pick of the smallest key beats a heap. The newest
+		// source wins ties, and every source with that key moves past it.
+		size_t visited = 0;
+
+		for (;;)
+		{
+			const Entry* smallest = nullptr;
+
+			for (const auto& cursor : cursors)
+			{
+				if (cursor.next != cursor.end && comp(cursor.next->first, to)
+					&& (smallest == nullptr || comp(cursor.next->first, smallest->first)))
+					smallest = cursor.next;
+			}
+
+			if (smallest == nullptr)
+				return visited;
+
+			if (!smallest->second.removed)
+			{
+				visit(smallest->first, smallest->second.value);
+				visited++;
+			}
+
+			TKey key = smallest->first;
+
+			for (auto& cursor : cursors)
+			{
+				if (cursor.next != cursor.end && !comp(key, cursor.next->first))
+					cursor.next++;
+			}
+		}
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void LsmStore<TKey, TValue, TComp>::flush()
+	{
+		if (memtable->size() == 0)
+			return;
+
+		std::shared_ptr<SortedRun> run = std::make_shared<SortedRun>();
+		run->entries.reserve(memtable->size());
+
+		memtable->forEach([&run](const TKey& key, const Slot& slot)
+		{
+			run->entries.push_back(Entry(key, slot));
+		});
+
+		addFences(*run);
+		memtable.reset(new Memtable(comp));
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			// Back pressure: writes outrunning compaction would pile up runs for every
+			// lookup to search.
+			changed.wait(lock, [this]() { return runs.size() < maxRuns; });
+			runs.insert(runs.begin(), run);
+		}
+
+		changed.notify_all();
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	size_t LsmStore<TKey, TValue, TComp>::findMerge() const
+	{
+		// A run at least half the size of the older one next to it is merged into it,
+		// oldest pair first: sizes then roughly double from the newest run to the oldest,
+		// and every entry is merged O(log n) times. At maxRuns, the newest pair anyway,
+		// so flush() cannot wait forever.
+		if (runs.size() >= maxRuns)
+			return 0;
+
+		for (size_t i = runs.size(); i-- > 1; )
+		{
+			if (runs[i - 1]->entries.size() * 2 >= runs[i]->entries.size())
+				return i - 1;
+		}
+
+		return runs.size();
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void LsmStore<TKey, TValue, TComp>::compactLoop()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		for (;;)
+		{
+			changed.wait(lock, [this]() { return stopping || findMerge() != runs.size(); });
+
+			if (stopping)
+				return;
+
+			size_t i = findMerge();
+			RunPtr newer = runs[i];
+			RunPtr older = runs[i + 1];
+			bool oldest = i + 2 == runs.size();
+			merging = true;
+
+			// Only this thread removes runs, and flush() adds them in front, so the pair
+			// is still next to each other, and still the oldest if it was, afterwards.
+			lock.unlock();
+			RunPtr merged = merge(*newer, *older, oldest);
+			lock.lock();
+
+			auto position = std::find(runs.begin(), runs.end(), newer);
+			*position = merged;
+			runs.erase(position + 1);
+			merging = false;
+
+			changed.notify_all();
+		}
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	typename LsmStore<TKey, TValue, TComp>::RunPtr
+		LsmStore<TKey, TValue, TComp>::merge(const SortedRun& newer, const SortedRun& older, bool oldest) const
+	{
+		std::vector<Entry> merged(newer.entries.size() + older.entries.size());
+
+		// Stable: of two entries with the same key, the newer one comes first.
+		parallelMerge(newer.entries.begin(), newer.entries.end(), older.entries.begin(), older.entries.end(),
+			merged.begin(), [this](const Entry& left, const Entry& right) { return less(left, right); });
+
+		std::shared_ptr<SortedRun> run = std::make_shared<SortedRun>();
+		run->entries.reserve(merged.size());
+
+		for (size_t i = 0; i < merged.size(); i++)
+		{
+			if (i > 0 && !comp(merged[i - 1].first, merged[i].first))
+				continue;
+
+			if (oldest && merged[i].second.removed)
+				continue;
+
+			run->entries.push_back(merged[i]);
+		}
+
+		addFences(*run);
+		return run;
+	}
+}
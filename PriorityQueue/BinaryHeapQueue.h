@@ -1,5 +1,7 @@
 #pragma once
 #include <functional>
+#include <iostream>
+#include "HeapAlgorithms.h"
 
 namespace algs {
 	using namespace std;
@@ -50,6 +52,19 @@ namespace algs {
 
 		void pop();
 
+		// Replaces the contents with [first, last), arranged into a heap in O(n) rather
+		// than with n pushes.
+		template <typename TIterator>
+		void assign(TIterator first, TIterator last);
+
+		// Calls visit(key) for every key, in the order of the heap array.
+		template <typename TFunc>
+		void forEach(TFunc visit) const
+		{
+			for (size_t i = 0; i < count; ++i)
+				visit(heap[i]);
+		}
+
 		void print()
 		{
 			for(int i = 0; i < count; ++i)
@@ -60,25 +75,16 @@ namespace algs {
 		}
 
 	private:
-		static size_t parent(size_t k)
+		void fixDown(size_t index)
 		{
-			return (k - 1) / 2;
+			siftDown(heap, count, index, comparer);
 		}
 
-		static size_t left(size_t k)
+		void fixUp(size_t index)
 		{
-			return 2 * k + 1;
+			siftUp(heap, index, comparer);
 		}
 
-		static size_t right(size_t k)
-		{
-			return 2 * k + 2;
-		}
-
-		void fixDown(size_t index);
-
-		void fixUp(size_t index);
-
 		void resize(size_t size)
 		{
 			auto newHeap = new TKey[size];
@@ -142,39 +148,21 @@ namespace algs {
 	}
 
 	template <typename TKey, typename TComp>
-	void BinaryHeapQueue<TKey, TComp>::fixDown(size_t index)
+	template <typename TIterator>
+	void BinaryHeapQueue<TKey, TComp>::assign(TIterator first, TIterator last)
 	{
-		auto l = left(index);
-		auto r = right(index);
-
-		size_t largest = index;
-		if (l < count && comparer(heap[index], heap[l]))
-		{
-			largest = l;
-		}
+		size_t size = static_cast<size_t>(std::distance(first, last));
 
-		if (r < count && comparer(heap[largest], heap[r]))
-		{
-			largest = r;
-		}
+		auto newHeap = new TKey[size + 1];
 
-		if (largest != index)
-		{
-			swap(heap[largest], heap[index]);
+		for (size_t i = 0; first != last; ++first, ++i)
+			newHeap[i] = *first;
 
-			fixDown(largest);
-		}
-	}
+		delete[]heap;
+		heap = newHeap;
+		count = size;
+		capacity = size + 1;
 
-	template <typename TKey, typename TComp>
-	void BinaryHeapQueue<TKey, TComp>::fixUp(size_t index)
-	{
-		TKey parentIndex = parent(index);
-		while (index > 0 && comparer(heap[parentIndex], heap[index]))
-		{
-			std::swap(heap[parentIndex], heap[index]);
-			index = parentIndex;
-			parentIndex = parent(index);
-		}
+		makeHeap(heap, heap + count, comparer);
 	}
 }
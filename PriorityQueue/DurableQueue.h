@@ -0,0 +1,864 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "BinaryHeapQueue.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef min
+#undef min
+#endif
+
+#ifdef max
+#undef max
+#endif
+
+namespace algs {
+
+	namespace detail {
+
+		// Header of both files. The snapshot fills in nextSequence and count; the log
+		// has its records in groups after it.
+		struct DurableHeader
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t keySize;
+			uint32_t reserved;
+			uint64_t epoch;
+			uint64_t nextSequence;
+			uint64_t count;
+		};
+
+		// Precedes the records of each group commit in the log.
+		struct GroupHeader
+		{
+			uint32_t size;
+			uint32_t checksum;
+		};
+
+		// Version 1 logged every push with its sequence number and every pop with a full one.
+		const uint32_t durableVersion = 2;
+
+		// FNV-1a over 64-bit words, folded to 32 bits: tells a group torn by a crash from
+		// a complete one.
+		inline uint32_t checksum(const char* data, size_t size)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			size_t i = 0;
+
+			for (; i + 8 <= size; i += 8)
+			{
+				uint64_t word;
+				std::memcpy(&word, data + i, 8);
+				hash = (hash ^ word) * 1099511628211ull;
+			}
+
+			for (; i < size; i++)
+				hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ull;
+
+			return static_cast<uint32_t>(hash ^ (hash >> 32));
+		}
+
+		// Reads a whole file. Returns false if it does not exist.
+		inline bool readFile(const std::string& fileName, std::vector<char>& contents)
+		{
+			std::ifstream file(fileName, std::ios_base::in | std::ios_base::binary);
+			if (!file)
+				return false;
+
+			file.seekg(0, std::ios_base::end);
+			contents.resize(static_cast<size_t>(file.tellg()));
+			file.seekg(0, std::ios_base::beg);
+			file.read(contents.data(), contents.size());
+
+			if (!file)
+				throw std::exception("Cannot read file");
+
+			return true;
+		}
+
+		// A file written from the start, with sync() to wait until what was written
+		// reaches the disk: std::ofstream's flush only hands it to the OS.
+		class SyncedFile
+		{
+		public:
+			SyncedFile() :
+#ifdef _WIN32
+				file(INVALID_HANDLE_VALUE)
+#else
+				file(-1)
+#endif
+			{
+			}
+
+			SyncedFile(const SyncedFile&) = delete;
+			SyncedFile& operator=(const SyncedFile&) = delete;
+
+			~SyncedFile()
+			{
+				close();
+			}
+
+			// Creates the file, or empties it.
+			void create(const std::string& fileName);
+
+			void append(const void* data, size_t size);
+
+			void sync();
+
+			void close();
+
+		private:
+#ifdef _WIN32
+			HANDLE file;
+#else
+			int file;
+#endif
+		};
+
+#ifdef _WIN32
+		inline void SyncedFile::create(const std::string& fileName)
+		{
+			close();
+
+			file = CreateFileA(fileName.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				throw std::exception("Cannot create file");
+		}
+
+		inline void SyncedFile::append(const void* data, size_t size)
+		{
+			const char* bytes = static_cast<const char*>(data);
+
+			while (size > 0)
+			{
+				DWORD chunk = static_cast<DWORD>(size < (1u << 30) ? size : (1u << 30));
+				DWORD written = 0;
+
+				if (!WriteFile(file, bytes, chunk, &written, nullptr))
+					throw std::exception("Cannot write file");
+
+				bytes += written;
+				size -= written;
+			}
+		}
+
+		inline void SyncedFile::sync()
+		{
+			if (!FlushFileBuffers(file))
+				throw std::exception("Cannot sync file");
+		}
+
+		inline void SyncedFile::close()
+		{
+			if (file != INVALID_HANDLE_VALUE)
+				CloseHandle(file);
+
+			file = INVALID_HANDLE_VALUE;
+		}
+
+		// Renames from to to, replacing to in one step.
+		inline void replaceFile(const std::string& from, const std::string& to)
+		{
+			if (!MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+				throw std::exception("Cannot replace file");
+		}
+#else
+		inline void SyncedFile::create(const std::string& fileName)
+		{
+			close();
+
+			file = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (file < 0)
+				throw std::exception("Cannot create file");
+		}
+
+		inline void SyncedFile::append(const void* data, size_t size)
+		{
+			const char* bytes = static_cast<const char*>(data);
+
+			while (size > 0)
+			{
+				ssize_t written = ::write(file, bytes, size);
+
+				if (written < 0)
+					throw std::exception("Cannot write file");
+
+				bytes += written;
+				size -= static_cast<size_t>(written);
+			}
+		}
+
+		inline void SyncedFile::sync()
+		{
+			if (::fsync(file) != 0)
+				throw std::exception("Cannot sync file");
+		}
+
+		inline void SyncedFile::close()
+		{
+			if (file >= 0)
+				::close(file);
+
+			file = -1;
+		}
+
+		// Renames from to to, replacing to in one step, and syncs the directory so the
+		// rename itself survives a crash.
+		inline void replaceFile(const std::string& from, const std::string& to)
+		{
+			if (::rename(from.c_str(), to.c_str()) != 0)
+				throw std::exception("Cannot replace file");
+
+			size_t slash = to.find_last_of('/');
+			std::string directory = slash == std::string::npos ? "." : to.substr(0, slash + 1);
+
+			int handle = ::open(directory.c_str(), O_RDONLY);
+			if (handle >= 0)
+			{
+				::fsync(handle);
+				::close(handle);
+			}
+		}
+#endif
+	}
+
+	// Priority queue that survives a crash: a BinaryHeapQueue in memory, backed by a
+	// write-ahead log of its pushes and pops and by snapshots of its heap array.
+	//
+	// push() and pop() change the heap and copy a record into a ring buffer shared with a
+	// writer thread; they only take a lock to wake the writer when it sleeps, and never
+	// wait for the disk unless the ring is full. The writer lets records gather for up to
+	// commitDelay microseconds, or until groupSize bytes are waiting, and commits them as
+	// one group with a single write and a single sync, so the cost of a sync is shared by
+	// all the operations of a group. sync() waits until the operations made so far are
+	// durable.
+	//
+	// Once the log holds more records than the queue has keys, and at least
+	// checkpointRecords, the heap array is copied and the writer saves it as a snapshot in
+	// place of the log, which starts over. Copying n keys after at least n operations costs
+	// O(1) per operation, and recovery never replays a log longer than the snapshot.
+	//
+	// Recovery reads the snapshot, appends the keys pushed in the log, drops the ones popped
+	// in it and builds the heap from the result in O(n) with makeHeap. Each key carries a
+	// 64-bit sequence number, which is what identifies it in a pop: recovery drops keys by
+	// number instead of replaying the pops, which would take O(log n) each. A push logs
+	// only its key, since pushes take the numbers in log order, and a pop logs how far
+	// back from the next number its key was pushed, in 32 bits when that fits. A group torn by a
+	// crash and what follows it is ignored. Recovery then writes a new snapshot so the
+	// next log starts empty.
+	//
+	// Files are fileName.snap and fileName.log. Keys are stored raw and have to be
+	// trivially copyable. One thread at a time may call the queue's methods.
+	template <
+		typename TKey,
+		typename TComp = std::less<TKey>
+	>
+	class DurableQueue
+	{
+		static_assert(std::is_trivially_copyable<TKey>::value, "Durable queues need trivially copyable keys");
+
+		struct Entry
+		{
+			TKey key;
+			uint64_t sequence;
+		};
+
+		struct EntryComp
+		{
+			TComp comp;
+
+			bool operator()(const Entry& left, const Entry& right) const
+			{
+				return comp(left.key, right.key);
+			}
+		};
+
+		enum RecordType : char
+		{
+			pushRecord = 'P',
+			popRecord = 'O',
+			recentPopRecord = 'R'
+		};
+
+		// What the writer thread is waiting for, so the queue only wakes it when needed.
+		enum WriterState
+		{
+			writerBusy,
+			writerIdle,
+			writerGathering
+		};
+
+		static constexpr size_t sequenceSize = sizeof(uint64_t);
+		static constexpr size_t entrySize = sequenceSize + sizeof(TKey);
+
+		static constexpr size_t ringSize = 1 << 22;
+
+		static constexpr int commitDelay = 1000;
+		static constexpr size_t groupSize = 1 << 16;
+
+	public:
+		explicit DurableQueue(const std::string& fileName, size_t checkpointRecords = 1 << 20) :
+			DurableQueue(fileName, TComp(), checkpointRecords)
+		{
+		}
+
+		DurableQueue(const std::string& fileName, const TComp& comp, size_t checkpointRecords = 1 << 20) :
+			fileName(fileName),
+			checkpointRecords(checkpointRecords),
+			heap(EntryComp{ comp }),
+			nextSequence(0),
+			logRecords(0),
+			written(0),
+			freeUntil(ringSize),
+			epoch(0),
+			ring(ringSize),
+			head(0),
+			tail(0),
+			state(writerBusy),
+			gatherUntil(0),
+			failed(false),
+			committed(0),
+			syncRequested(false),
+			checkpointRequested(false),
+			checkpointPosition(0),
+			checkpointSequence(0),
+			stopping(false)
+		{
+			recover();
+
+			std::vector<Entry> entries;
+			heap.forEach([&entries](const Entry& entry) { entries.push_back(entry); });
+			writeCheckpoint(entries, nextSequence);
+
+			writer = std::thread([this]() { writeLoop(); });
+		}
+
+		DurableQueue(const DurableQueue&) = delete;
+		DurableQueue& operator=(const DurableQueue&) = delete;
+
+		// Commits what is left in the ring.
+		~DurableQueue()
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				stopping = true;
+			}
+
+			wake.notify_one();
+			writer.join();
+		}
+
+		size_t size() const
+		{
+			return heap.size();
+		}
+
+		bool empty() const
+		{
+			return heap.empty();
+		}
+
+		void push(const TKey& key);
+
+		const TKey& top()
+		{
+			return heap.top().key;
+		}
+
+		void pop();
+
+		// Waits until every push and pop made so far is on disk.
+		void sync();
+
+	private:
+		// Takes the record as an array so its size is known and the copy into the ring is
+		// a few moves instead of a call.
+		template <size_t Size>
+		void append(const char (&record)[Size]);
+
+		// Waits until the writer has freed size bytes of the ring.
+		void waitForRoom(size_t size);
+
+		void maybeCheckpoint();
+
+		void recover();
+
+		void writeLoop();
+
+		// Writes records as one group and syncs the log.
+		void commitGroup(const char* records, size_t size);
+
+		// Saves the entries as the snapshot of the next epoch and starts its empty log.
+		void writeCheckpoint(const std::vector<Entry>& entries, uint64_t sequence);
+
+		static void encode(char* out, const Entry& entry)
+		{
+			std::memcpy(out, &entry.sequence, sequenceSize);
+			std::memcpy(out + sequenceSize, &entry.key, sizeof(TKey));
+		}
+
+		static Entry decode(const char* in)
+		{
+			Entry entry;
+			std::memcpy(&entry.sequence, in, sequenceSize);
+			std::memcpy(&entry.key, in + sequenceSize, sizeof(TKey));
+			return entry;
+		}
+
+		static detail::DurableHeader makeHeader(const char* magic, uint64_t epoch)
+		{
+			detail::DurableHeader header = {};
+			std::memcpy(header.magic, magic, 4);
+			header.version = detail::durableVersion;
+			header.keySize = sizeof(TKey);
+			header.epoch = epoch;
+			return header;
+		}
+
+		static bool validHeader(const std::vector<char>& contents, const char* magic, detail::DurableHeader& header)
+		{
+			if (contents.size() < sizeof(header))
+				return false;
+
+			std::memcpy(&header, contents.data(), sizeof(header));
+			return std::memcmp(header.magic, magic, 4) == 0
+				&& header.version == detail::durableVersion
+				&& header.keySize == sizeof(TKey);
+		}
+
+		std::string snapshotName() const
+		{
+			return fileName + ".snap";
+		}
+
+		std::string logName() const
+		{
+			return fileName + ".log";
+		}
+
+	private:
+		const std::string fileName;
+		const size_t checkpointRecords;
+
+		// Touched by the calling thread only. written is the ring position after the last
+		// record; freeUntil the position up to which the ring was last seen free.
+		BinaryHeapQueue<Entry, EntryComp> heap;
+		uint64_t nextSequence;
+		size_t logRecords;
+		uint64_t written;
+		uint64_t freeUntil;
+
+		// Touched by the writer thread only, once it runs.
+		uint64_t epoch;
+		detail::SyncedFile log;
+		std::vector<char> group;
+
+		// Records from position tail to head, modulo ringSize, wait for the writer. Only
+		// the queue moves head and only the writer moves tail.
+		std::vector<char> ring;
+		std::atomic<uint64_t> head;
+		std::atomic<uint64_t> tail;
+
+		std::atomic<int> state;
+		std::atomic<uint64_t> gatherUntil;
+		std::atomic<bool> failed;
+
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable durable;
+
+		// Guarded by lock. committed is the ring position up to which records are on disk.
+		uint64_t committed;
+		bool syncRequested;
+
+		// A heap copy to save in place of the records before checkpointPosition.
+		bool checkpointRequested;
+		std::vector<Entry> checkpointEntries;
+		uint64_t checkpointPosition;
+		uint64_t checkpointSequence;
+
+		bool stopping;
+		std::thread writer;
+	};
+
+	// wait_for() takes the delay by reference, so before C++17 it needs a definition.
+	template <typename TKey, typename TComp>
+	constexpr int DurableQueue<TKey, TComp>::commitDelay;
+
+	template <typename TKey, typename TComp>
+	void DurableQueue<TKey, TComp>::push(const TKey& key)
+	{
+		Entry entry = { key, nextSequence++ };
+		heap.push(entry);
+
+		char record[1 + sizeof(TKey)];
+		record[0] = pushRecord;
+		std::memcpy(record + 1, &key, sizeof(TKey));
+		append(record);
+	}
+
+	template <typename TKey, typename TComp>
+	void DurableQueue<TKey, TComp>::pop()
+	{
+		uint64_t distance = nextSequence - heap.top().sequence;
+		heap.pop();
+
+		if (distance <= UINT32_MAX)
+		{
+			uint32_t shortDistance = static_cast<uint32_t>(distance);
+			char record[1 + sizeof(shortDistance)];
+			record[0] = recentPopRecord;
+			std::memcpy(record + 1, &shortDistance, sizeof(shortDistance));
+			append(record);
+		}
+		else
+		{
+			char record[1 + sizeof(distance)];
+			record[0] = popRecord;
+			std::memcpy(record + 1, &distance, sizeof(distance));
+			append(record);
+		}
+	}
+
+	template <typename TKey, typename TComp>
+	void DurableQueue<TKey, TComp>::sync()
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		uint64_t target = written;
+
+		syncRequested = true;
+		wake.notify_one();
+
+		durable.wait(guard, [this, target]() { return committed >= target || failed; });
+
+		if (failed)
+			throw std::exception("Cannot write log");
+	}
+
+	template <typename TKey, typename TComp>
+	template <size_t Size>
+	void DurableQueue<TKey, TComp>::append(const char (&record)[Size])
+	{
+		if (failed.load(std::memory_order_relaxed))
+			throw std::exception("Cannot write log");
+
+		if (written + Size > freeUntil)
+			waitForRoom(Size);
+
+		size_t offset = static_cast<size_t>(written % ringSize);
+		if (Size <= ringSize - offset)
+		{
+			std::memcpy(&ring[offset], record, Size);
+		}
+		else
+		{
+			std::memcpy(&ring[offset], record, ringSize - offset);
+			std::memcpy(&ring[0], record + ringSize - offset, Size - (ringSize - offset));
+		}
+
+		written += Size;
+		head.store(written);
+
+		// Pairs with the writer storing its state before it checks head: either it sees
+		// this record or the queue sees it waiting.
+		int current = state.load();
+		if (current == writerIdle || (current == writerGathering && written >= gatherUntil.load()))
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock);
+			}
+
+			wake.notify_one();
+		}
+
+		logRecords++;
+		maybeCheckpoint();
+	}
+
+	template <typename TKey, typename TComp>
+	void DurableQueue<TKey, TComp>::waitForRoom(size_t size)
+	{
+		freeUntil = tail.load(std::memory_order_acquire) + ringSize;
+		if (written + size <= freeUntil)
+			return;
+
+		std::unique_lock<std::mutex> guard(lock);
+
+		syncRequested = true;
+		wake.notify_one();
+
+		durable.wait(guard, [this, size]()
+		{
+			freeUntil = tail.load(std::memory_order_acquire) + ringSize;
+			return written + size <= freeUntil || failed;
+		});
+
+		if (failed)
+			throw std::exception("Cannot write log");
+	}
+
+	template <typename TKey, typename TComp>
+	void DurableQueue<TKey, TComp>::maybeCheckpoint()
+	{
+		if (logRecords < checkpointRecords || logRecords < heap.size())
+			return;
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (checkpointRequested)
+				return;
+		}
+
+		std::vector<Entry> entries;
+		entries.reserve(heap.size());
+		heap.forEach([&entries](const Entry& entry) { entries.push_back(entry); });
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			checkpointRequested = true;
+			checkpointEntries = std::move(entries);
+			checkpointPosition = written;
+			checkpointSequence = nextSequence;
+		}
+
+		logRecords = 0;
+		wake.notify_one();
+	}
+
+	template <typename TKey, typename TComp>
+	void DurableQueue<TKey, TComp>::recover()
+	{
+		std::vector<char> contents;
+		std::vector<Entry> entries;
+		detail::DurableHeader header;
+
+		if (detail::readFile(snapshotName(), contents))
+		{
+			if (!validHeader(contents, "PQSN", header)
+				|| contents.size() < sizeof(header) + header.count * entrySize)
+				throw std::exception("Invalid snapshot");
+
+			epoch = header.epoch;
+			nextSequence = header.nextSequence;
+
+			entries.reserve(static_cast<size_t>(header.count));
+			for (size_t i = 0; i < header.count; i++)
+				entries.push_back(decode(&contents[sizeof(header) + i * entrySize]));
+		}
+
+		std::unordered_set<uint64_t> popped;
+
+		// A log of another epoch was replaced by the snapshot before it could be emptied.
+		if (detail::readFile(logName(), contents) && validHeader(contents, "PQLG", header) && header.epoch == epoch)
+		{
+			size_t position = sizeof(header);
+			detail::GroupHeader groupHeader;
+
+			while (position + sizeof(groupHeader) <= contents.size())
+			{
+				std::memcpy(&groupHeader, &contents[position], sizeof(groupHeader));
+				position += sizeof(groupHeader);
+
+				if (groupHeader.size > contents.size() - position
+					|| detail::checksum(&contents[position], groupHeader.size) != groupHeader.checksum)
+					break;
+
+				for (size_t end = position + groupHeader.size; position < end; )
+				{
+					if (contents[position] == pushRecord)
+					{
+						Entry entry;
+						std::memcpy(&entry.key, &contents[position + 1], sizeof(TKey));
+						entry.sequence = nextSequence++;
+						entries.push_back(entry);
+						position += 1 + sizeof(TKey);
+					}
+					else if (contents[position] == recentPopRecord)
+					{
+						uint32_t distance;
+						std::memcpy(&distance, &contents[position + 1], sizeof(distance));
+						popped.insert(nextSequence - distance);
+						position += 1 + sizeof(distance);
+					}
+					else
+					{
+						uint64_t distance;
+						std::memcpy(&distance, &contents[position + 1], sizeof(distance));
+						popped.insert(nextSequence - distance);
+						position += 1 + sizeof(distance);
+					}
+				}
+			}
+		}
+
+		if (!popped.empty())
+		{
+			size_t kept = 0;
+
+			for (const auto& entry : entries)
+			{
+				if (popped.find(entry.sequence) == popped.end())
+					entries[kept++] = entry;
+			}
+
+			entries.resize(kept);
+		}
+
+		heap.assign(entries.begin(), entries.end());
+	}
+
+	template <typename TKey, typename TComp>
+	void DurableQueue<TKey, TComp>::writeLoop()
+	{
+		uint64_t consumed = 0;
+
+		for (;;)
+		{
+			std::unique_lock<std::mutex> guard(lock);
+
+			state.store(writerIdle);
+			wake.wait(guard, [this, consumed]()
+			{
+				return stopping || syncRequested || checkpointRequested || head.load() != consumed;
+			});
+
+			if (stopping && !checkpointRequested && head.load() == consumed)
+				return;
+
+			gatherUntil.store(consumed + groupSize);
+			state.store(writerGathering);
+			wake.wait_for(guard, std::chrono::microseconds(commitDelay), [this, consumed]()
+			{
+				return stopping || syncRequested || head.load() >= consumed + groupSize;
+			});
+
+			state.store(writerBusy);
+
+			// Whatever came in since the last commit is the next group.
+			uint64_t end = head.load(std::memory_order_acquire);
+			syncRequested = false;
+
+			bool checkpoint = checkpointRequested;
+			std::vector<Entry> entries = std::move(checkpointEntries);
+			uint64_t sequence = checkpointSequence;
+
+			// The records before a checkpoint are in its snapshot: they go nowhere.
+			uint64_t begin = checkpoint ? checkpointPosition : consumed;
+
+			guard.unlock();
+
+			// The queue does not touch the ring between tail and head, so a group is
+			// committed straight from it unless it wraps around the end.
+			size_t size = static_cast<size_t>(end - begin);
+			size_t offset = static_cast<size_t>(begin % ringSize);
+			const char* records = &ring[offset];
+
+			if (size > ringSize - offset)
+			{
+				group.resize(size);
+				std::memcpy(&group[0], &ring[offset], ringSize - offset);
+				std::memcpy(&group[ringSize - offset], &ring[0], size - (ringSize - offset));
+				records = group.data();
+			}
+
+			bool ok = true;
+
+			try
+			{
+				if (checkpoint)
+					writeCheckpoint(entries, sequence);
+
+				commitGroup(records, size);
+			}
+			catch (const std::exception&)
+			{
+				ok = false;
+			}
+
+			consumed = end;
+			tail.store(end, std::memory_order_release);
+
+			guard.lock();
+
+			if (checkpoint)
+				checkpointRequested = false;
+
+			if (ok)
+				committed = end;
+			else
+				failed = true;
+
+			durable.notify_all();
+
+			if (!ok)
+				return;
+		}
+	}
+
+	template <typename TKey, typename TComp>
+	void DurableQueue<TKey, TComp>::commitGroup(const char* records, size_t size)
+	{
+		if (size == 0)
+			return;
+
+		detail::GroupHeader header = { static_cast<uint32_t>(size), detail::checksum(records, size) };
+		log.append(&header, sizeof(header));
+		log.append(records, size);
+		log.sync();
+	}
+
+	template <typename TKey, typename TComp>
+	void DurableQueue<TKey, TComp>::writeCheckpoint(const std::vector<Entry>& entries, uint64_t sequence)
+	{
+		std::vector<char> contents(sizeof(detail::DurableHeader) + entries.size() * entrySize);
+
+		detail::DurableHeader header = makeHeader("PQSN", epoch + 1);
+		header.nextSequence = sequence;
+		header.count = entries.size();
+		std::memcpy(contents.data(), &header, sizeof(header));
+
+		for (size_t i = 0; i < entries.size(); i++)
+			encode(&contents[sizeof(header) + i * entrySize], entries[i]);
+
+		std::string temporaryName = snapshotName() + ".tmp";
+		detail::SyncedFile snapshot;
+		snapshot.create(temporaryName);
+		snapshot.append(contents.data(), contents.size());
+		snapshot.sync();
+		snapshot.close();
+
+		// From here on recovery reads the new snapshot and ignores the old log.
+		detail::replaceFile(temporaryName, snapshotName());
+		epoch++;
+
+		header = makeHeader("PQLG", epoch);
+		log.create(logName());
+		log.append(&header, sizeof(header));
+		log.sync();
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+// Binary heap operations on random-access ranges: the root of the heap is first[0],
+// the children of first[i] are first[2i + 1] and first[2i + 2], and no element is less
+// than its children under comp. BinaryHeapQueue keeps its array in this shape.
+namespace algs {
+
+	// Moves first[index] up to where it belongs, for a heap that is valid except that
+	// first[index] may be greater than its parent.
+	template <typename RandomAccessIterator, typename Compare>
+	void siftUp(RandomAccessIterator first, size_t index, Compare& comp)
+	{
+		auto value = std::move(first[index]);
+
+		while (index > 0)
+		{
+			size_t parent = (index - 1) / 2;
+
+			if (!comp(first[parent], value))
+				break;
+
+			first[index] = std::move(first[parent]);
+			index = parent;
+		}
+
+		first[index] = std::move(value);
+	}
+
+	// Moves first[index] down to where it belongs in the heap first[0 .. size), for a heap
+	// that is valid except that first[index] may be less than its children.
+	//
+	// Bottom-up (Floyd, Wegener): the hole left by first[index] goes all the way down to a
+	// leaf along the greater children, one comparison per level, and the element then
+	// climbs back up from there. The element usually came from the bottom of the heap and
+	// belongs near it, so the climb is short: about log n comparisons per sift instead of
+	// the 2 log n of comparing the element with both children at every level.
+	template <typename RandomAccessIterator, typename Compare>
+	void siftDown(RandomAccessIterator first, size_t size, size_t index, Compare& comp)
+	{
+		auto value = std::move(first[index]);
+		size_t top = index;
+		size_t child = 2 * index + 2;
+
+		for (; child < size; child = 2 * index + 2)
+		{
+			if (comp(first[child], first[child - 1]))
+				child--;
+
+			first[index] = std::move(first[child]);
+			index = child;
+		}
+
+		// A last node with a left child only.
+		if (child == size)
+		{
+			first[index] = std::move(first[child - 1]);
+			index = child - 1;
+		}
+
+		while (index > top)
+		{
+			size_t parent = (index - 1) / 2;
+
+			if (!comp(first[parent], value))
+				break;
+
+			first[index] = std::move(first[parent]);
+			index = parent;
+		}
+
+		first[index] = std::move(value);
+	}
+
+	// Arranges [first, last) into a heap in O(n), sifting down from the last parent.
+	template <typename RandomAccessIterator, typename Compare>
+	void makeHeap(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+	{
+		size_t size = static_cast<size_t>(last - first);
+
+		for (size_t index = size / 2; index-- > 0; )
+			siftDown(first, size, index, comp);
+	}
+
+	// In-place heapsort: builds a heap, then moves its top to the end of the shrinking
+	// heap n - 1 times. O(n log n) in the worst case, about n log2 n comparisons with the
+	// bottom-up sift, no allocation. Not stable.
+	template <typename RandomAccessIterator, typename Compare>
+	void heapSort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+	{
+		makeHeap(first, last, comp);
+
+		for (size_t size = static_cast<size_t>(last - first); size > 1; size--)
+		{
+			std::iter_swap(first, first + (size - 1));
+			siftDown(first, size - 1, 0, comp);
+		}
+	}
+
+	template <typename RandomAccessIterator>
+	void heapSort(RandomAccessIterator first, RandomAccessIterator last)
+	{
+		heapSort(first, last, std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>());
+	}
+}
@@ -2,9 +2,19 @@
 //
 
 #include "stdafx.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <queue>
 #include <iostream>
+#include <random>
+#include <string>
+#include <vector>
 #include "BinaryHeapQueue.h"
+#include "DurableQueue.h"
+#include "HeapAlgorithms.h"
+#include "TimingWheel.h"
 
 using namespace std;
 
@@ -17,6 +27,107 @@ void print_queue(T& q) {
 	std::cout << '\n';
 }
 
+// Timer churn: every tick starts timersPerTick timers due within maxDelay ticks, and
+// 95% of them are cancelled a few ticks later. The wheel cancels in place; the heap,
+// which cannot, leaves a cancelled flag and skips the timer when it reaches the top.
+const uint64_t ticks = 100000;
+const int timersPerTick = 20;
+const uint64_t maxDelay = 60000;
+
+struct Deadline
+{
+	uint64_t tick;
+	uint32_t id;
+};
+
+struct LaterDeadline
+{
+	bool operator()(const Deadline& left, const Deadline& right) const
+	{
+		return left.tick > right.tick;
+	}
+};
+
+template <typename TStart, typename TCancel, typename TTick>
+void runChurn(const char* name, TStart start, TCancel cancel, TTick tick)
+{
+	mt19937 rng(1);
+	std::vector<std::vector<uint32_t>> cancels(128);
+	uint32_t id = 0;
+	size_t fired = 0;
+
+	auto begin = chrono::steady_clock::now();
+
+	for (uint64_t now = 1; now <= ticks; now++)
+	{
+		for (int i = 0; i < timersPerTick; i++, id++)
+		{
+			start(now + 1 + rng() % maxDelay, id);
+
+			if (rng() % 100 < 95)
+				cancels[(now + 1 + rng() % 100) % cancels.size()].push_back(id);
+		}
+
+		for (uint32_t cancelled : cancels[now % cancels.size()])
+			cancel(cancelled);
+		cancels[now % cancels.size()].clear();
+
+		fired += tick(now);
+	}
+
+	chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - begin;
+	cout << name << ": " << elapsed.count() << " ms for " << id << " timers, " << fired << " fired" << endl;
+}
+
+// Runs op on a copy of input and reports the time, whether the copy ended up sorted
+// and the details op returns.
+template <typename TOp>
+void measure(const char* name, const std::vector<int>& input, TOp op)
+{
+	std::vector<int> copy = input;
+
+	auto begin = chrono::steady_clock::now();
+	string details = op(copy);
+	chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - begin;
+
+	cout << name << ": " << elapsed.count() << " ms, sorted " << boolalpha << is_sorted(copy.begin(), copy.end())
+		<< ", " << details << endl;
+}
+
+// Less that counts its calls in comparisons.
+auto countingLess(size_t& comparisons)
+{
+	return [&comparisons](int left, int right) { comparisons++; return left < right; };
+}
+
+string comparisonsPerNLogN(size_t comparisons, size_t size)
+{
+	double n = static_cast<double>(size);
+	return to_string(comparisons / (n * log2(n))) + " comparisons per n log2 n";
+}
+
+// Pushes operations keys and pops after every second push, then reports the time.
+template <typename TQueue, typename TFinish>
+void runScheduler(const char* name, TQueue& queue, TFinish finish)
+{
+	const int operations = 2000000;
+	mt19937 rng(3);
+
+	auto begin = chrono::steady_clock::now();
+
+	for (int i = 0; i < operations; i++)
+	{
+		queue.push(static_cast<int>(rng()));
+		if (i % 2 == 1)
+			queue.pop();
+	}
+
+	finish(queue);
+
+	chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - begin;
+	cout << name << ": " << elapsed.count() << " ms, " << queue.size() << " keys left" << endl;
+}
+
 int main()
 {
 	algs::BinaryHeapQueue<int> hq;
@@ -40,7 +151,88 @@ int main()
 		q3.push(n);
 	}
 	print_queue(q3);
-	
+
+	algs::TimingWheel<uint32_t> wheel;
+	std::vector<algs::TimerHandle> handles;
+	runChurn("TimingWheel",
+		[&](uint64_t deadline, uint32_t id) { handles.push_back(wheel.insert(deadline, id)); },
+		[&](uint32_t id) { wheel.cancel(handles[id]); },
+		[&](uint64_t now) { return wheel.advance(now, [](uint32_t) { }); });
+	cout << "Pending timers: " << wheel.size() << endl;
+
+	algs::BinaryHeapQueue<Deadline, LaterDeadline> heap;
+	std::vector<bool> cancelled;
+	runChurn("BinaryHeapQueue",
+		[&](uint64_t deadline, uint32_t id) { heap.push(Deadline{ deadline, id }); cancelled.push_back(false); },
+		[&](uint32_t id) { cancelled[id] = true; },
+		[&](uint64_t now)
+		{
+			size_t fired = 0;
+			for (; !heap.empty() && heap.top().tick <= now; heap.pop())
+				fired += !cancelled[heap.top().id];
+			return fired;
+		});
+	cout << "Heap entries: " << heap.size() << endl;
+
+	std::vector<int> values(1 << 20);
+	mt19937 rng(2);
+	for (auto& value : values)
+		value = static_cast<int>(rng());
+
+	measure("std::sort", values, [](std::vector<int>& v)
+	{
+		size_t comparisons = 0;
+		sort(v.begin(), v.end(), countingLess(comparisons));
+		return comparisonsPerNLogN(comparisons, v.size());
+	});
+	measure("std::make_heap, std::sort_heap", values, [](std::vector<int>& v)
+	{
+		size_t comparisons = 0;
+		make_heap(v.begin(), v.end(), countingLess(comparisons));
+		sort_heap(v.begin(), v.end(), countingLess(comparisons));
+		return comparisonsPerNLogN(comparisons, v.size());
+	});
+	measure("BinaryHeapQueue push, pop", values, [](std::vector<int>& v)
+	{
+		size_t comparisons = 0;
+		auto less = countingLess(comparisons);
+		algs::BinaryHeapQueue<int, decltype(less)> queue(less);
+		for (int value : v)
+			queue.push(value);
+		for (size_t i = v.size(); i-- > 0; queue.pop())
+			v[i] = queue.top();
+		return comparisonsPerNLogN(comparisons, v.size());
+	});
+	measure("algs::heapSort", values, [](std::vector<int>& v)
+	{
+		size_t comparisons = 0;
+		algs::heapSort(v.begin(), v.end(), countingLess(comparisons));
+		return comparisonsPerNLogN(comparisons, v.size());
+	});
+
+	const string fileName = "durable-queue";
+	remove((fileName + ".snap").c_str());
+	remove((fileName + ".log").c_str());
+
+	algs::BinaryHeapQueue<int> memoryQueue;
+	runScheduler("BinaryHeapQueue", memoryQueue, [](algs::BinaryHeapQueue<int>&) { });
+
+	{
+		algs::DurableQueue<int> durableQueue(fileName);
+		runScheduler("DurableQueue", durableQueue, [](algs::DurableQueue<int>& queue) { queue.sync(); });
+	}
+
+	{
+		auto begin = chrono::steady_clock::now();
+		algs::DurableQueue<int> recovered(fileName);
+		chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - begin;
+		cout << "Recovered " << recovered.size() << " keys in " << elapsed.count() << " ms, top "
+			<< recovered.top() << " (" << memoryQueue.top() << " in memory)" << endl;
+	}
+
+	remove((fileName + ".snap").c_str());
+	remove((fileName + ".log").c_str());
+
 	return 0;
 }
 
@@ -0,0 +1,378 @@
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <vector>
+#include "BinaryHeapQueue.h"
+
+namespace algs {
+
+	// Identifies a timer for cancel(). Stays safe to use after the timer fired or was
+	// cancelled: the slot it points to then has another generation.
+	struct TimerHandle
+	{
+		uint32_t index;
+		uint32_t generation;
+	};
+
+	// Hierarchical timing wheel (Varghese and Lauck) for timers with integer tick
+	// deadlines. levels wheels of slotsPerLevel slots each: a timer due within 64 ticks
+	// sits in the level 0 slot of its tick, one due within 64^2 ticks in the level 1 slot
+	// of its block of 64 ticks, and so on. Each time level 0 wraps around, the next level 1
+	// slot is cascaded: its timers move down to the level 0 slots of their ticks. Deadlines
+	// beyond the top level go to an overflow BinaryHeapQueue and enter the wheel when they
+	// come in range.
+	//
+	// Timers live in a pool and each slot is an intrusive doubly linked list of pool
+	// indices, so insert and cancel are O(1) whatever the number of pending timers; a
+	// timer cancelled before it fires never costs more than that. Each timer is cascaded
+	// at most once per level. TValue is what the expiry callback receives.
+	template <typename TValue>
+	class TimingWheel
+	{
+		static constexpr uint32_t levelBits = 6;
+		static constexpr uint32_t slotsPerLevel = 1u << levelBits;
+		static constexpr uint32_t levels = 4;
+
+		// Deadlines at least this far away go to the overflow heap.
+		static constexpr uint64_t wheelRange = uint64_t(1) << (levelBits * levels);
+
+		static constexpr uint32_t none = UINT32_MAX;
+
+		// Values of Timer::bucket besides level * slotsPerLevel + slot.
+		static constexpr uint16_t freeBucket = 0xFFFF;
+		static constexpr uint16_t overflowBucket = 0xFFFE;
+
+		struct Timer
+		{
+			uint64_t deadline;
+			TValue value;
+			uint32_t prev;
+			uint32_t next;
+			uint32_t generation;
+			uint16_t bucket;
+		};
+
+		struct OverflowEntry
+		{
+			uint64_t deadline;
+			uint32_t index;
+			uint32_t generation;
+		};
+
+		// BinaryHeapQueue keeps the greatest entry on top: the latest deadline is the least.
+		struct Later
+		{
+			bool operator()(const OverflowEntry& left, const OverflowEntry& right) const
+			{
+				return left.deadline > right.deadline;
+			}
+		};
+
+	public:
+		explicit TimingWheel(uint64_t now = 0) :
+			current(now),
+			count(0),
+			freeList(none),
+			overflowLive(0)
+		{
+			for (auto& head : heads)
+				head = none;
+		}
+
+		TimingWheel(const TimingWheel&) = delete;
+		TimingWheel& operator=(const TimingWheel&) = delete;
+
+		// Adds a timer that fires on the tick deadline, or on the next tick if that
+		// has passed.
+		TimerHandle insert(uint64_t deadline, const TValue& value);
+
+		// Removes a pending timer. Returns false if it already fired or was cancelled.
+		bool cancel(TimerHandle handle);
+
+		// Moves the time forward to tick to, one tick at a time, and calls visit(value)
+		// for every timer that comes due, in deadline order. The timers of a tick are taken
+		// off the wheel before their callbacks run, so callbacks may insert and cancel
+		// timers. Returns the number of timers that fired.
+		template <typename TFunc>
+		size_t advance(uint64_t to, TFunc visit);
+
+		uint64_t now() const
+		{
+			return current;
+		}
+
+		// Pending timers.
+		size_t size() const
+		{
+			return count;
+		}
+
+		bool empty() const
+		{
+			return count == 0;
+		}
+
+	private:
+		static uint16_t bucketOf(uint32_t level, uint64_t deadline)
+		{
+			return static_cast<uint16_t>(level * slotsPerLevel + ((deadline >> (level * levelBits)) & (slotsPerLevel - 1)));
+		}
+
+		// Links the timer into the slot for its deadline, which is not before current.
+		void place(uint32_t index);
+
+		void link(uint32_t index, uint16_t bucket)
+		{
+			Timer& timer = timers[index];
+			timer.bucket = bucket;
+			timer.prev = none;
+			timer.next = heads[bucket];
+
+			if (timer.next != none)
+				timers[timer.next].prev = index;
+
+			heads[bucket] = index;
+		}
+
+		void unlink(uint32_t index)
+		{
+			Timer& timer = timers[index];
+
+			if (timer.prev != none)
+				timers[timer.prev].next = timer.next;
+			else
+				heads[timer.bucket] = timer.next;
+
+			if (timer.next != none)
+				timers[timer.next].prev = timer.prev;
+		}
+
+		void release(uint32_t index)
+		{
+			Timer& timer = timers[index];
+			timer.bucket = freeBucket;
+			timer.generation++;
+			timer.next = freeList;
+			freeList = index;
+			count--;
+		}
+
+		// Empties a slot of level and places its timers again, one level down or more.
+		void cascade(uint32_t level, uint64_t deadline);
+
+		// Moves the overflow timers that came in range into the wheel.
+		void drainOverflow();
+
+		// Rebuilds the overflow heap without its cancelled entries, once they outnumber
+		// the live ones, so a churn of far-future timers does not grow it forever. Makes
+		// cancel O(log n) amortized for timers in the overflow heap.
+		void pruneOverflow();
+
+	private:
+		uint64_t current;
+		size_t count;
+
+		std::vector<Timer> timers;
+		uint32_t freeList;
+
+		uint32_t heads[levels * slotsPerLevel];
+
+		// Entries of cancelled timers stay until they reach the top or the heap is pruned.
+		BinaryHeapQueue<OverflowEntry, Later> overflow;
+		size_t overflowLive;
+
+		// Values of the timers that fire on the current tick.
+		std::vector<TValue> batch;
+	};
+
+	template <typename TValue>
+	TimerHandle TimingWheel<TValue>::insert(uint64_t deadline, const TValue& value)
+	{
+		if (deadline <= current)
+			deadline = current + 1;
+
+		uint32_t index;
+
+		if (freeList != none)
+		{
+			index = freeList;
+			freeList = timers[index].next;
+		}
+		else
+		{
+			if (timers.size() == none)
+				throw std::exception("Too many timers");
+
+			index = static_cast<uint32_t>(timers.size());
+			timers.push_back(Timer());
+			timers[index].generation = 0;
+		}
+
+		Timer& timer = timers[index];
+		timer.deadline = deadline;
+		timer.value = value;
+		count++;
+
+		place(index);
+
+		return TimerHandle{ index, timer.generation };
+	}
+
+	template <typename TValue>
+	bool TimingWheel<TValue>::cancel(TimerHandle handle)
+	{
+		if (handle.index >= timers.size())
+			return false;
+
+		Timer& timer = timers[handle.index];
+
+		if (timer.generation != handle.generation || timer.bucket == freeBucket)
+			return false;
+
+		if (timer.bucket != overflowBucket)
+		{
+			unlink(handle.index);
+			release(handle.index);
+			return true;
+		}
+
+		// The heap entry stays behind.
+		release(handle.index);
+		overflowLive--;
+
+		if (overflow.size() > 2 * overflowLive + 64)
+			pruneOverflow();
+
+		return true;
+	}
+
+	template <typename TValue>
+	void TimingWheel<TValue>::place(uint32_t index)
+	{
+		uint64_t deadline = timers[index].deadline;
+		uint64_t delta = deadline - current;
+
+		if (delta >= wheelRange)
+		{
+			timers[index].bucket = overflowBucket;
+			overflow.push(OverflowEntry{ deadline, index, timers[index].generation });
+			overflowLive++;
+			return;
+		}
+
+		uint32_t level = 0;
+		while (delta >= (uint64_t(1) << ((level + 1) * levelBits)))
+			level++;
+
+		link(index, bucketOf(level, deadline));
+	}
+
+	template <typename TValue>
+	void TimingWheel<TValue>::cascade(uint32_t level, uint64_t deadline)
+	{
+		uint16_t bucket = bucketOf(level, deadline);
+		uint32_t index = heads[bucket];
+		heads[bucket] = none;
+
+		while (index != none)
+		{
+			uint32_t next = timers[index].next;
+			place(index);
+			index = next;
+		}
+	}
+
+	template <typename TValue>
+	void TimingWheel<TValue>::drainOverflow()
+	{
+		while (!overflow.empty() && overflow.top().deadline < current + wheelRange)
+		{
+			OverflowEntry entry = overflow.top();
+			overflow.pop();
+
+			Timer& timer = timers[entry.index];
+			if (timer.generation != entry.generation || timer.bucket != overflowBucket)
+				continue;
+
+			overflowLive--;
+			place(entry.index);
+		}
+	}
+
+	template <typename TValue>
+	void TimingWheel<TValue>::pruneOverflow()
+	{
+		std::vector<OverflowEntry> live;
+		live.reserve(overflowLive);
+
+		while (!overflow.empty())
+		{
+			OverflowEntry entry = overflow.top();
+			overflow.pop();
+
+			const Timer& timer = timers[entry.index];
+			if (timer.generation == entry.generation && timer.bucket == overflowBucket)
+				live.push_back(entry);
+		}
+
+		for (const auto& entry : live)
+			overflow.push(entry);
+	}
+
+	template <typename TValue>
+	template <typename TFunc>
+	size_t TimingWheel<TValue>::advance(uint64_t to, TFunc visit)
+	{
+		size_t fired = 0;
+
+		while (current < to)
+		{
+			// Nothing pending: no slot can fill up until the next insert. The overflow
+			// heap may still hold entries of cancelled timers, which would be skipped over.
+			if (count == 0)
+			{
+				if (!overflow.empty())
+					pruneOverflow();
+
+				current = to;
+				break;
+			}
+
+			current++;
+
+			// Each level wraps around when the one above moves on to its next slot.
+			for (uint32_t level = 1; level < levels; level++)
+			{
+				if ((current & ((uint64_t(1) << (level * levelBits)) - 1)) != 0)
+					break;
+
+				cascade(level, current);
+			}
+
+			drainOverflow();
+
+			uint16_t bucket = bucketOf(0, current);
+			if (heads[bucket] == none)
+				continue;
+
+			batch.clear();
+
+			for (uint32_t index = heads[bucket]; index != none; )
+			{
+				uint32_t next = timers[index].next;
+				batch.push_back(timers[index].value);
+				release(index);
+				index = next;
+			}
+
+			heads[bucket] = none;
+			fired += batch.size();
+
+			for (const auto& value : batch)
+				visit(value);
+		}
+
+		return fired;
+	}
+}
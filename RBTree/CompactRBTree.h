@@ -0,0 +1,721 @@
+#pragma once
+
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace algs {
+
+	// Red-black tree with the same queries as RBTree, whose nodes live in one
+	// contiguous arena and link to each other by 32-bit indices. The parent index
+	// and the colour share a word, and the nil node is slot 0 of the arena instead
+	// of a separate allocation. An int -> int node takes 20 bytes instead of
+	// RBTree's 32, nodes allocated together sit next to each other in memory, and
+	// freed slots are reused by later inserts. Up to 2^31 - 1 entries.
+	// Inserts may move the arena: keep keys, not references, across them.
+	template <
+		typename TKey,
+		typename TValue,
+		typename TComp = std::less<TKey>
+	>
+	class CompactRBTree
+	{
+		typedef uint32_t Index;
+
+		static constexpr bool black = false;
+		static constexpr bool red = true;
+
+		static constexpr Index nil = 0;
+
+		static constexpr Index maxSize = 0x7FFFFFFF;
+
+		struct Node
+		{
+			Index left;
+			Index right;
+
+			// Parent index shifted left by one, colour in the lowest bit.
+			uint32_t parentColor;
+
+			std::pair<TKey, TValue> keyValue;
+
+			Node() :
+				left(nil),
+				right(nil),
+				parentColor(black),
+				keyValue(std::pair<TKey, TValue>())
+			{
+			}
+
+			Node(const TKey& key, const TValue& value) :
+				left(nil),
+				right(nil),
+				parentColor(red),
+				keyValue(key, value)
+			{
+			}
+
+			const TKey& key() const { return keyValue.first; }
+
+			TValue& value() { return keyValue.second; }
+
+			const TValue& value() const { return keyValue.second; }
+		};
+
+	public:
+		explicit CompactRBTree() :
+			comp(),
+			nodes(1),
+			root(nil),
+			freeList(nil),
+			count(0)
+		{
+		}
+
+		explicit CompactRBTree(const TComp& comp) :
+			comp(comp),
+			nodes(1),
+			root(nil),
+			freeList(nil),
+			count(0)
+		{
+		}
+
+		const TValue& find(const TKey& key) const
+		{
+			Index index = findNode(key);
+
+			if (index == nil)
+				throw std::exception("Cannot find node");
+
+			return nodes[index].value();
+		}
+
+		// Lookup by any type the comparator can compare with TKey (see RBTree::find).
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		const TValue& find(const TLookup& key) const
+		{
+			Index index = findNode(key);
+
+			if (index == nil)
+				throw std::exception("Cannot find node");
+
+			return nodes[index].value();
+		}
+
+		bool contains(const TKey& key) const
+		{
+			return findNode(key) != nil;
+		}
+
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		bool contains(const TLookup& key) const
+		{
+			return findNode(key) != nil;
+		}
+
+		std::pair<const TKey&, const TValue&> min() const
+		{
+			if (root == nil)
+				throw std::exception("Cannot find node");
+
+			const Node& node = nodes[findMinNode(root)];
+			return std::pair<const TKey&, const TValue&>(node.key(), node.value());
+		}
+
+		std::pair<const TKey&, const TValue&> max() const
+		{
+			if (root == nil)
+				throw std::exception("Cannot find node");
+
+			const Node& node = nodes[findMaxNode(root)];
+			return std::pair<const TKey&, const TValue&>(node.key(), node.value());
+		}
+
+		const TKey& successor(const TKey& key) const;
+
+		const TKey& predecessor(const TKey& key) const;
+
+		void insert(const TKey& key, const TValue& value);
+
+		void remove(const TKey& key);
+
+		// Reserves arena slots for n entries in total, so inserts up to that size
+		// neither reallocate nor move the nodes.
+		void reserve(size_t n)
+		{
+			nodes.reserve(n + 1);
+		}
+
+		void print() const
+		{
+			forEach([](const TKey& key, const TValue& value)
+			{
+				std::cout << key << " (" << value << ") ";
+			});
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		bool empty() const
+		{
+			return count == 0;
+		}
+
+		// Bytes of arena per stored entry, counting slots that are free or reserved.
+		size_t bytesPerEntry() const
+		{
+			return count == 0 ? 0 : nodes.capacity() * sizeof(Node) / count;
+		}
+
+		// Calls visit(key, value) for every entry in key order.
+		template <typename TFunc>
+		void forEach(TFunc visit) const
+		{
+			if (root == nil)
+				return;
+
+			for (Index index = findMinNode(root); index != nil; index = nextNode(index))
+				visit(nodes[index].key(), nodes[index].value());
+		}
+
+		size_t height() const;
+
+	private:
+		Index parent(Index index) const
+		{
+			return nodes[index].parentColor >> 1;
+		}
+
+		void setParent(Index index, Index parentIndex)
+		{
+			nodes[index].parentColor = (parentIndex << 1) | (nodes[index].parentColor & 1);
+		}
+
+		bool color(Index index) const
+		{
+			return (nodes[index].parentColor & 1) != 0;
+		}
+
+		void setColor(Index index, bool color)
+		{
+			nodes[index].parentColor = (nodes[index].parentColor & ~uint32_t(1)) | (color ? 1 : 0);
+		}
+
+		Index& left(Index index)
+		{
+			return nodes[index].left;
+		}
+
+		Index& right(Index index)
+		{
+			return nodes[index].right;
+		}
+
+		// Takes a slot from the free list, or appends one to the arena.
+		Index allocate(const TKey& key, const TValue& value);
+
+		void release(Index index);
+
+		Index findMinNode(Index index) const
+		{
+			while (nodes[index].left != nil)
+				index = nodes[index].left;
+
+			return index;
+		}
+
+		Index findMaxNode(Index index) const
+		{
+			while (nodes[index].right != nil)
+				index = nodes[index].right;
+
+			return index;
+		}
+
+		template <typename TLookup>
+		Index findNode(const TLookup& key) const;
+
+		Index nextNode(Index index) const;
+
+		void insertFixup(Index index);
+
+		void removeFixup(Index index);
+
+		void rotateLeft(Index index);
+
+		void rotateRight(Index index);
+
+		void transplant(Index prevIndex, Index newIndex);
+
+	private:
+		TComp comp;
+		std::vector<Node> nodes;
+		Index root;
+
+		// Free slots, linked through their left index.
+		Index freeList;
+		size_t count;
+	};
+
+	template <typename TKey, typename TValue, typename TComp>
+	typename CompactRBTree<TKey, TValue, TComp>::Index
+		CompactRBTree<TKey, TValue, TComp>::allocate(const TKey& key, const TValue& value)
+	{
+		if (freeList != nil)
+		{
+			Index index = freeList;
+			freeList = nodes[index].left;
+			nodes[index] = Node(key, value);
+			return index;
+		}
+
+		if (nodes.size() > maxSize)
+			throw std::exception("Tree is full");
+
+		nodes.push_back(Node(key, value));
+		return static_cast<Index>(nodes.size() - 1);
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void CompactRBTree<TKey, TValue, TComp>::release(Index index)
+	{
+		// Drop the entry now rather than when the slot is reused.
+		nodes[index] = Node();
+		nodes[index].left = freeList;
+		freeList = index;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	template <typename TLookup>
+	typename CompactRBTree<TKey, TValue, TComp>::Index
+		CompactRBTree<TKey, TValue, TComp>::findNode(const TLookup& key) const
+	{
+		Index index = root;
+
+		while (index != nil)
+		{
+			const Node& node = nodes[index];
+
+			if (comp(key, node.key()))
+				index = node.left;
+			else if (comp(node.key(), key))
+				index = node.right;
+			else
+				break;
+		}
+
+		return index;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	typename CompactRBTree<TKey, TValue, TComp>::Index
+		CompactRBTree<TKey, TValue, TComp>::nextNode(Index index) const
+	{
+		if (nodes[index].right != nil)
+			return findMinNode(nodes[index].right);
+
+		Index ptr = parent(index);
+
+		while (ptr != nil && index == nodes[ptr].right)
+		{
+			index = ptr;
+			ptr = parent(ptr);
+		}
+
+		return ptr;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	const TKey& CompactRBTree<TKey, TValue, TComp>::successor(const TKey& key) const
+	{
+		Index index = findNode(key);
+
+		if (index == nil)
+			throw std::exception("Cannot find node");
+
+		Index next = nextNode(index);
+
+		if (next == nil)
+			throw std::exception("Cannot find successor");
+
+		return nodes[next].key();
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	const TKey& CompactRBTree<TKey, TValue, TComp>::predecessor(const TKey& key) const
+	{
+		Index index = findNode(key);
+
+		if (index == nil)
+			throw std::exception("Cannot find node");
+
+		if (nodes[index].left != nil)
+			return nodes[findMaxNode(nodes[index].left)].key();
+
+		Index ptr = parent(index);
+
+		while (ptr != nil && index == nodes[ptr].left)
+		{
+			index = ptr;
+			ptr = parent(ptr);
+		}
+
+		if (ptr == nil)
+			throw std::exception("Cannot find predecessor");
+
+		return nodes[ptr].key();
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void CompactRBTree<TKey, TValue, TComp>::insert(const TKey& key, const TValue& value)
+	{
+		// Allocate first: growing the arena moves every node.
+		Index newIndex = allocate(key, value);
+
+		Index parentIndex = nil;
+		Index current = root;
+
+		while (current != nil)
+		{
+			parentIndex = current;
+			current = comp(key, nodes[current].key()) ? nodes[current].left : nodes[current].right;
+		}
+
+		setParent(newIndex, parentIndex);
+
+		if (parentIndex == nil)
+			root = newIndex;
+		else if (comp(key, nodes[parentIndex].key()))
+			left(parentIndex) = newIndex;
+		else
+			right(parentIndex) = newIndex;
+
+		insertFixup(newIndex);
+		count++;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void CompactRBTree<TKey, TValue, TComp>::remove(const TKey& key)
+	{
+		Index z = findNode(key);
+		if (z == nil)
+			return;
+
+		Index y = z;
+		bool yOriginalColor = color(y);
+		Index x = nil;
+
+		if (left(z) == nil)
+		{
+			x = right(z);
+			transplant(z, right(z));
+		}
+		else if (right(z) == nil)
+		{
+			x = left(z);
+			transplant(z, left(z));
+		}
+		else
+		{
+			y = findMinNode(right(z));
+			yOriginalColor = color(y);
+			x = right(y);
+
+			if (parent(y) == z)
+			{
+				setParent(x, y);
+			}
+			else
+			{
+				transplant(y, right(y));
+				right(y) = right(z);
+				setParent(right(y), y);
+			}
+
+			transplant(z, y);
+			left(y) = left(z);
+			setParent(left(y), y);
+			setColor(y, color(z));
+		}
+
+		if (yOriginalColor == black)
+			removeFixup(x);
+
+		release(z);
+		count--;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	size_t CompactRBTree<TKey, TValue, TComp>::height() const
+	{
+		if (root == nil)
+			return 0;
+
+		// Depth-first walk over parent indices, as in RBTree::height().
+		size_t h = 0;
+		size_t depth = 1;
+		Index prev = nil;
+		Index index = root;
+
+		while (index != nil)
+		{
+			const Node& node = nodes[index];
+			Index next;
+
+			if (prev == parent(index))
+			{
+				h = std::max(h, depth);
+
+				if (node.left != nil)
+					next = node.left;
+				else if (node.right != nil)
+					next = node.right;
+				else
+					next = parent(index);
+			}
+			else if (prev == node.left && node.right != nil)
+			{
+				next = node.right;
+			}
+			else
+			{
+				next = parent(index);
+			}
+
+			if (next == parent(index))
+				depth--;
+			else
+				depth++;
+
+			prev = index;
+			index = next;
+		}
+
+		return h;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void CompactRBTree<TKey, TValue, TComp>::insertFixup(Index z)
+	{
+		while (color(parent(z)) == red)
+		{
+			Index p = parent(z);
+			Index g = parent(p);
+
+			if (p == left(g))
+			{
+				Index uncle = right(g);
+
+				if (color(uncle) == red)
+				{
+					// Case 1.
+					setColor(p, black);
+					setColor(uncle, black);
+					setColor(g, red);
+					z = g;
+				}
+				else
+				{
+					if (z == right(p))
+					{
+						// Case 2.
+						z = p;
+						rotateLeft(z);
+					}
+
+					// Case 3.
+					setColor(parent(z), black);
+					setColor(parent(parent(z)), red);
+					rotateRight(parent(parent(z)));
+				}
+			}
+			else
+			{
+				Index uncle = left(g);
+
+				if (color(uncle) == red)
+				{
+					// Case 1.
+					setColor(p, black);
+					setColor(uncle, black);
+					setColor(g, red);
+					z = g;
+				}
+				else
+				{
+					if (z == left(p))
+					{
+						// Case 2.
+						z = p;
+						rotateRight(z);
+					}
+
+					// Case 3.
+					setColor(parent(z), black);
+					setColor(parent(parent(z)), red);
+					rotateLeft(parent(parent(z)));
+				}
+			}
+		}
+
+		setColor(root, black);
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void CompactRBTree<TKey, TValue, TComp>::removeFixup(Index x)
+	{
+		while (x != root && color(x) == black)
+		{
+			if (x == left(parent(x)))
+			{
+				Index w = right(parent(x));
+
+				if (color(w) == red)
+				{
+					// Case 1.
+					setColor(w, black);
+					setColor(parent(x), red);
+					rotateLeft(parent(x));
+					w = right(parent(x));
+				}
+
+				if (color(left(w)) == black && color(right(w)) == black)
+				{
+					// Case 2.
+					setColor(w, red);
+					x = parent(x);
+				}
+				else
+				{
+					if (color(right(w)) == black)
+					{
+						// Case 3.
+						setColor(left(w), black);
+						setColor(w, red);
+						rotateRight(w);
+						w = right(parent(x));
+					}
+
+					// Case 4.
+					setColor(w, color(parent(x)));
+					setColor(parent(x), black);
+					setColor(right(w), black);
+					rotateLeft(parent(x));
+					x = root;
+				}
+			}
+			else
+			{
+				Index w = left(parent(x));
+
+				if (color(w) == red)
+				{
+					// Case 1.
+					setColor(w, black);
+					setColor(parent(x), red);
+					rotateRight(parent(x));
+					w = left(parent(x));
+				}
+
+				if (color(right(w)) == black && color(left(w)) == black)
+				{
+					// Case 2.
+					setColor(w, red);
+					x = parent(x);
+				}
+				else
+				{
+					if (color(left(w)) == black)
+					{
+						// Case 3.
+						setColor(right(w), black);
+						setColor(w, red);
+						rotateLeft(w);
+						w = left(parent(x));
+					}
+
+					// Case 4.
+					setColor(w, color(parent(x)));
+					setColor(parent(x), black);
+					setColor(left(w), black);
+					rotateRight(parent(x));
+					x = root;
+				}
+			}
+		}
+
+		setColor(x, black);
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void CompactRBTree<TKey, TValue, TComp>::rotateLeft(Index x)
+	{
+		Index y = right(x);
+		right(x) = left(y);
+
+		if (left(y) != nil)
+			setParent(left(y), x);
+
+		setParent(y, parent(x));
+		if (parent(x) == nil)
+			root = y;
+		else if (x == left(parent(x)))
+			left(parent(x)) = y;
+		else
+			right(parent(x)) = y;
+
+		left(y) = x;
+		setParent(x, y);
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void CompactRBTree<TKey, TValue, TComp>::rotateRight(Index x)
+	{
+		Index y = left(x);
+		left(x) = right(y);
+
+		if (right(y) != nil)
+			setParent(right(y), x);
+
+		setParent(y, parent(x));
+		if (parent(x) == nil)
+			root = y;
+		else if (x == left(parent(x)))
+			left(parent(x)) = y;
+		else
+			right(parent(x)) = y;
+
+		right(y) = x;
+		setParent(x, y);
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void CompactRBTree<TKey, TValue, TComp>::transplant(Index prevIndex, Index newIndex)
+	{
+		Index p = parent(prevIndex);
+
+		if (p == nil)
+			root = newIndex;
+		else if (prevIndex == left(p))
+			left(p) = newIndex;
+		else
+			right(p) = newIndex;
+
+		setParent(newIndex, p);
+	}
+}
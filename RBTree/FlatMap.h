@@ -0,0 +1,286 @@
+#pragma once
+
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace algs {
+
+	// Ordered map over two parallel sorted arrays, for build-once, query-many data.
+	// Exposes the same queries as RBTree, but searches run over contiguous keys with
+	// a branchless binary search instead of chasing pointers. Single inserts and removes
+	// are O(n); bulk loads should go through insertBatch() or freeze().
+	// Like RBTree, equal keys are kept side by side in insertion order.
+	template <
+		typename TKey,
+		typename TValue,
+		typename TComp = std::less<TKey>
+	>
+	class FlatMap
+	{
+	public:
+		explicit FlatMap() :
+			comp()
+		{
+		}
+
+		explicit FlatMap(const TComp& comp) :
+			comp(comp)
+		{
+		}
+
+		// Builds the map from any tree exposing size() and an in-order forEach(),
+		// e.g. RBTree or RandomizedBST, in O(n).
+		template <typename TTree>
+		static FlatMap freeze(const TTree& tree, const TComp& comp = TComp())
+		{
+			FlatMap map(comp);
+			map.keys.reserve(tree.size());
+			map.values.reserve(tree.size());
+
+			tree.forEach([&map](const TKey& key, const TValue& value)
+			{
+				map.keys.push_back(key);
+				map.values.push_back(value);
+			});
+
+			return map;
+		}
+
+		size_t size() const
+		{
+			return keys.size();
+		}
+
+		bool empty() const
+		{
+			return keys.empty();
+		}
+
+		const TValue& find(const TKey& key) const
+		{
+			return values[findIndex(key)];
+		}
+
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		const TValue& find(const TLookup& key) const
+		{
+			return values[findIndex(key)];
+		}
+
+		bool contains(const TKey& key) const
+		{
+			size_t index = lowerBound(key);
+			return index < keys.size() && !comp(key, keys[index]);
+		}
+
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		bool contains(const TLookup& key) const
+		{
+			size_t index = lowerBound(key);
+			return index < keys.size() && !comp(key, keys[index]);
+		}
+
+		std::pair<const TKey&, const TValue&> min() const
+		{
+			if (keys.empty())
+				throw std::exception("Cannot find node");
+
+			return std::pair<const TKey&, const TValue&>(keys.front(), values.front());
+		}
+
+		std::pair<const TKey&, const TValue&> max() const
+		{
+			if (keys.empty())
+				throw std::exception("Cannot find node");
+
+			return std::pair<const TKey&, const TValue&>(keys.back(), values.back());
+		}
+
+		const TKey& successor(const TKey& key) const
+		{
+			size_t index = findIndex(key);
+
+			if (index + 1 == keys.size())
+				throw std::exception("Cannot find successor");
+
+			return keys[index + 1];
+		}
+
+		const TKey& predecessor(const TKey& key) const
+		{
+			size_t index = findIndex(key);
+
+			if (index == 0)
+				throw std::exception("Cannot find predecessor");
+
+			return keys[index - 1];
+		}
+
+		// Index of the first key not less than key, size() if there is none.
+		template <typename TLookup>
+		size_t lowerBound(const TLookup& key) const;
+
+		// Index of the first key greater than key, size() if there is none.
+		template <typename TLookup>
+		size_t upperBound(const TLookup& key) const;
+
+		const TKey& keyAt(size_t index) const
+		{
+			return keys[index];
+		}
+
+		const TValue& valueAt(size_t index) const
+		{
+			return values[index];
+		}
+
+		// Calls visit(key, value) for every entry with from <= key < to, in order.
+		// Returns the number of entries visited.
+		template <typename TFunc>
+		size_t range(const TKey& from, const TKey& to, TFunc visit) const
+		{
+			size_t first = lowerBound(from);
+			size_t index = first;
+
+			for (; index < keys.size() && comp(keys[index], to); ++index)
+				visit(keys[index], values[index]);
+
+			return index - first;
+		}
+
+		void insert(const TKey& key, const TValue& value)
+		{
+			size_t index = upperBound(key);
+			keys.insert(keys.begin() + index, key);
+			values.insert(values.begin() + index, value);
+		}
+
+		// Sorts the batch and merges it into the arrays in a single backward pass,
+		// O(n + m log m) for m new entries instead of m separate O(n) inserts.
+		template <typename TIterator>
+		void insertBatch(TIterator first, TIterator last);
+
+		void remove(const TKey& key)
+		{
+			size_t index = lowerBound(key);
+			if (index == keys.size() || comp(key, keys[index]))
+				return;
+
+			keys.erase(keys.begin() + index);
+			values.erase(values.begin() + index);
+		}
+
+		void print() const
+		{
+			for (size_t index = 0; index < keys.size(); ++index)
+				std::cout << keys[index] << " (" << values[index] << ") ";
+		}
+
+	private:
+		template <typename TLookup>
+		size_t findIndex(const TLookup& key) const
+		{
+			size_t index = lowerBound(key);
+
+			if (index == keys.size() || comp(key, keys[index]))
+				throw std::exception("Cannot find node");
+
+			return index;
+		}
+
+	private:
+		TComp comp;
+		std::vector<TKey> keys;
+		std::vector<TValue> values;
+	};
+
+	template <typename TKey, typename TValue, typename TComp>
+	template <typename TLookup>
+	size_t FlatMap<TKey, TValue, TComp>::lowerBound(const TLookup& key) const
+	{
+		if (keys.empty())
+			return 0;
+
+		// The loop does not depend on comparison outcomes, only the base moves:
+		// the compiler turns the select into a conditional move.
+		const TKey* base = keys.data();
+		size_t n = keys.size();
+
+		while (n > 1)
+		{
+			size_t half = n / 2;
+			base = comp(base[half], key) ? base + half : base;
+			n -= half;
+		}
+
+		return (base - keys.data()) + (comp(*base, key) ? 1 : 0);
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	template <typename TLookup>
+	size_t FlatMap<TKey, TValue, TComp>::upperBound(const TLookup& key) const
+	{
+		if (keys.empty())
+			return 0;
+
+		const TKey* base = keys.data();
+		size_t n = keys.size();
+
+		while (n > 1)
+		{
+			size_t half = n / 2;
+			base = comp(key, base[half]) ? base : base + half;
+			n -= half;
+		}
+
+		return (base - keys.data()) + (comp(key, *base) ? 0 : 1);
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	template <typename TIterator>
+	void FlatMap<TKey, TValue, TComp>::insertBatch(TIterator first, TIterator last)
+	{
+		std::vector<std::pair<TKey, TValue>> batch(first, last);
+		std::stable_sort(batch.begin(), batch.end(),
+			[this](const std::pair<TKey, TValue>& left, const std::pair<TKey, TValue>& right)
+		{
+			return comp(left.first, right.first);
+		});
+
+		size_t existing = keys.size();
+		size_t added = batch.size();
+		keys.resize(existing + added);
+		values.resize(existing + added);
+
+		// Fill from the back so nothing is overwritten before it has been moved.
+		// On equal keys the batch entry goes last, keeping insertion order.
+		size_t out = existing + added;
+		while (added > 0)
+		{
+			--out;
+			if (existing > 0 && comp(batch[added - 1].first, keys[existing - 1]))
+			{
+				--existing;
+				keys[out] = std::move(keys[existing]);
+				values[out] = std::move(values[existing]);
+			}
+			else
+			{
+				--added;
+				keys[out] = std::move(batch[added].first);
+				values[out] = std::move(batch[added].second);
+			}
+		}
+	}
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <iostream>
+#include <functional>
+#include <utility>
+#include "RBTree.h"
+
+namespace algs {
+
+	// Augmentation for IntervalTree: the largest interval end in a subtree.
+	// Values are (end, payload) pairs.
+	template <
+		typename TPoint,
+		typename TValue,
+		typename TComp = std::less<TPoint>
+	>
+	struct MaxEndAugment
+	{
+		typedef TPoint Summary;
+
+		explicit MaxEndAugment(const TComp& comp = TComp()) :
+			comp(comp)
+		{
+		}
+
+		Summary entry(const TPoint&, const std::pair<TPoint, TValue>& value) const
+		{
+			return value.first;
+		}
+
+		Summary combine(const Summary& left, const Summary& right) const
+		{
+			return comp(left, right) ? right : left;
+		}
+
+		TComp comp;
+	};
+
+	// Closed intervals [start, end], each with a payload, in an RBTree keyed by
+	// start whose nodes also keep the largest end in their subtree. A query skips
+	// every subtree that ends before the query range and stops going right once
+	// starts pass its end, so finding the k intervals that overlap a range costs
+	// O(log n + k) instead of a scan. Equal intervals may be stored more than once.
+	template <
+		typename TPoint,
+		typename TValue,
+		typename TComp = std::less<TPoint>
+	>
+	class IntervalTree
+	{
+		typedef MaxEndAugment<TPoint, TValue, TComp> Augment;
+		typedef RBTree<TPoint, std::pair<TPoint, TValue>, TComp, Augment> Tree;
+		typedef typename Tree::Node Node;
+
+	public:
+		explicit IntervalTree() :
+			comp(),
+			tree(TComp(), Augment())
+		{
+		}
+
+		explicit IntervalTree(const TComp& comp) :
+			comp(comp),
+			tree(comp, Augment(comp))
+		{
+		}
+
+		IntervalTree(const IntervalTree&) = delete;
+		IntervalTree& operator=(const IntervalTree&) = delete;
+
+		void insert(const TPoint& start, const TPoint& end, const TValue& value)
+		{
+			if (comp(end, start))
+				throw std::exception("Interval ends before it starts");
+
+			tree.insert(start, std::make_pair(end, value));
+		}
+
+		// Removes one interval equal to [start, end], if there is any.
+		void remove(const TPoint& start, const TPoint& end);
+
+		// Calls visit(start, end, value) for every interval that shares at least
+		// one point with [from, to], in order of start, and returns their number.
+		template <typename TFunc>
+		size_t forEachOverlap(const TPoint& from, const TPoint& to, TFunc visit) const
+		{
+			return overlap(tree.root, from, to, visit);
+		}
+
+		// Intervals that contain point.
+		template <typename TFunc>
+		size_t forEachContaining(const TPoint& point, TFunc visit) const
+		{
+			return overlap(tree.root, point, point, visit);
+		}
+
+		// Calls visit(start, end, value) for every interval in order of start.
+		template <typename TFunc>
+		void forEach(TFunc visit) const
+		{
+			tree.forEach([&visit](const TPoint& start, const std::pair<TPoint, TValue>& value)
+			{
+				visit(start, value.first, value.second);
+			});
+		}
+
+		void print() const
+		{
+			forEach([](const TPoint& start, const TPoint& end, const TValue& value)
+			{
+				std::cout << "[" << start << ", " << end << "](" << value << ") ";
+			});
+		}
+
+		size_t size() const
+		{
+			return tree.size();
+		}
+
+		bool empty() const
+		{
+			return tree.size() == 0;
+		}
+
+		size_t height() const
+		{
+			return tree.height();
+		}
+
+	private:
+		template <typename TFunc>
+		size_t overlap(Node* node, const TPoint& from, const TPoint& to, TFunc& visit) const;
+
+	private:
+		TComp comp;
+		Tree tree;
+	};
+
+	template <typename TPoint, typename TValue, typename TComp>
+	void IntervalTree<TPoint, TValue, TComp>::remove(const TPoint& start, const TPoint& end)
+	{
+		// Intervals with the same start are neighbours in key order: find the first
+		// of them and walk along to the one with the same end.
+		Node* first = tree.sentinel;
+
+		for (Node* node = tree.root; node != tree.sentinel; )
+		{
+			if (comp(node->key(), start))
+			{
+				node = node->right;
+			}
+			else
+			{
+				first = node;
+				node = node->left;
+			}
+		}
+
+		for (Node* node = first; node != tree.sentinel && !comp(start, node->key()); node = tree.nextNode(node))
+		{
+			const TPoint& nodeEnd = node->value().first;
+
+			if (!comp(nodeEnd, end) && !comp(end, nodeEnd))
+			{
+				tree.removeNode(node);
+				return;
+			}
+		}
+	}
+
+	template <typename TPoint, typename TValue, typename TComp>
+	template <typename TFunc>
+	size_t IntervalTree<TPoint, TValue, TComp>::overlap(Node* node, const TPoint& from, const TPoint& to, TFunc& visit) const
+	{
+		size_t found = 0;
+
+		// Subtrees whose largest end is before from hold no match. Recurse to the left
+		// and loop to the right, so the stack never grows deeper than the tree.
+		while (node != tree.sentinel && !comp(node->summary, from))
+		{
+			found += overlap(node->left, from, to, visit);
+
+			// This node and everything to its right start after to.
+			if (comp(to, node->key()))
+				break;
+
+			if (!comp(node->value().first, from))
+			{
+				visit(node->key(), node->value().first, node->value().second);
+				found++;
+			}
+
+			node = node->right;
+		}
+
+		return found;
+	}
+}
@@ -0,0 +1,754 @@
+#pragma once
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <utility>
+
+namespace algs {
+
+	// Persistent red-black tree: insert and remove leave the tree untouched and
+	// return a new version that copies only the search path (plus O(1) siblings
+	// touched by rebalancing) and shares every other subtree with the original.
+	// Copying a version is O(1), versions may be handed to other threads, and a
+	// node is freed when the last version referencing it is destroyed.
+	template <
+		typename TKey,
+		typename TValue,
+		typename TComp = std::less<TKey>
+	>
+	class PersistentRBTree
+	{
+		static constexpr bool black = false;
+		static constexpr bool red = true;
+
+		// A red-black tree with n < 2^64 nodes is at most 2 * log2(n + 1) high.
+		static constexpr int maxHeight = 130;
+
+		struct Node
+		{
+			Node* left;
+			Node* right;
+
+			std::pair<TKey, TValue> keyValue;
+
+			bool color;
+
+			// Number of parents (across all versions) and version roots pointing here.
+			std::atomic<size_t> refs;
+
+			Node(const TKey& key, const TValue& value) :
+				left(nullptr),
+				right(nullptr),
+				keyValue(key, value),
+				color(red),
+				refs(1)
+			{
+			}
+
+			// The copy takes its own reference to both children.
+			explicit Node(const Node* other) :
+				left(other->left),
+				right(other->right),
+				keyValue(other->keyValue),
+				color(other->color),
+				refs(1)
+			{
+				if (left != nullptr)
+					left->refs.fetch_add(1, std::memory_order_relaxed);
+				if (right != nullptr)
+					right->refs.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			const TKey& key() const { return keyValue.first; }
+
+			const TValue& value() const { return keyValue.second; }
+		};
+
+	public:
+		explicit PersistentRBTree() :
+			comp(),
+			root(nullptr),
+			count(0)
+		{
+		}
+
+		explicit PersistentRBTree(const TComp& comp) :
+			comp(comp),
+			root(nullptr),
+			count(0)
+		{
+		}
+
+		// Snapshot: shares the whole tree.
+		PersistentRBTree(const PersistentRBTree& other) :
+			comp(other.comp),
+			root(other.root),
+			count(other.count)
+		{
+			if (root != nullptr)
+				root->refs.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		PersistentRBTree(PersistentRBTree&& other) :
+			comp(other.comp),
+			root(other.root),
+			count(other.count)
+		{
+			other.root = nullptr;
+			other.count = 0;
+		}
+
+		PersistentRBTree& operator=(PersistentRBTree other)
+		{
+			std::swap(comp, other.comp);
+			std::swap(root, other.root);
+			std::swap(count, other.count);
+			return *this;
+		}
+
+		~PersistentRBTree()
+		{
+			release(root);
+		}
+
+		PersistentRBTree insert(const TKey& key, const TValue& value) const;
+
+		// Returns a version equal to this one if the key is not present.
+		PersistentRBTree remove(const TKey& key) const;
+
+		const TValue& find(const TKey& key) const;
+
+		// Lookup by any type the comparator can compare with TKey (see RBTree::find).
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		const TValue& find(const TLookup& key) const
+		{
+			Node* ptr = findNode(key);
+
+			if (ptr == nullptr)
+				throw std::exception("Cannot find node");
+
+			return ptr->value();
+		}
+
+		bool contains(const TKey& key) const
+		{
+			return findNode(key) != nullptr;
+		}
+
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		bool contains(const TLookup& key) const
+		{
+			return findNode(key) != nullptr;
+		}
+
+		std::pair<const TKey&, const TValue&> min() const;
+
+		std::pair<const TKey&, const TValue&> max() const;
+
+		const TKey& successor(const TKey& key) const;
+
+		const TKey& predecessor(const TKey& key) const;
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		bool empty() const
+		{
+			return count == 0;
+		}
+
+		void print() const;
+
+		size_t height() const;
+
+	private:
+		PersistentRBTree(const TComp& comp, Node* root, size_t count) :
+			comp(comp),
+			root(root),
+			count(count)
+		{
+		}
+
+		static bool isRed(const Node* node)
+		{
+			return node != nullptr && node->color == red;
+		}
+
+		// Drops one reference to node and frees every node that is no longer referenced.
+		// Subtrees are released depth-first with a stack bounded by the tree height.
+		static void release(Node* node);
+
+		// Replaces parent's child by a private copy so it can be recoloured or rotated.
+		static Node* copyChild(Node* parent, bool leftChild);
+
+		static void replaceChild(Node* parent, Node* oldChild, Node* newChild, Node*& root)
+		{
+			if (parent == nullptr)
+				root = newChild;
+			else if (parent->left == oldChild)
+				parent->left = newChild;
+			else
+				parent->right = newChild;
+		}
+
+		static void rotateLeft(Node* nodePtr, Node* parent, Node*& root);
+
+		static void rotateRight(Node* nodePtr, Node* parent, Node*& root);
+
+		template <typename TLookup>
+		Node* findNode(const TLookup& key) const;
+
+		static const Node* findMinNode(const Node* node);
+
+		static const Node* findMaxNode(const Node* node);
+
+	private:
+		TComp comp;
+		Node* root;
+		size_t count;
+	};
+
+	template <typename TKey, typename TValue, typename TComp>
+	void PersistentRBTree<TKey, TValue, TComp>::release(Node* node)
+	{
+		if (node == nullptr || node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		Node* stack[maxHeight];
+		int top = 0;
+
+		while (true)
+		{
+			while (node != nullptr)
+			{
+				Node* left = node->left;
+				Node* right = node->right;
+				delete node;
+
+				if (right != nullptr && right->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					stack[top++] = right;
+
+				node = (left != nullptr && left->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) ? left : nullptr;
+			}
+
+			if (top == 0)
+				break;
+
+			node = stack[--top];
+		}
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	typename PersistentRBTree<TKey, TValue, TComp>::Node*
+		PersistentRBTree<TKey, TValue, TComp>::copyChild(Node* parent, bool leftChild)
+	{
+		Node*& child = leftChild ? parent->left : parent->right;
+		Node* copy = new Node(child);
+
+		// The old child is still referenced by the version we copied from, so this never frees it.
+		child->refs.fetch_sub(1, std::memory_order_relaxed);
+		child = copy;
+
+		return copy;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void PersistentRBTree<TKey, TValue, TComp>::rotateLeft(Node* nodePtr, Node* parent, Node*& root)
+	{
+		Node* tmp = nodePtr->right;
+		nodePtr->right = tmp->left;
+		tmp->left = nodePtr;
+		replaceChild(parent, nodePtr, tmp, root);
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void PersistentRBTree<TKey, TValue, TComp>::rotateRight(Node* nodePtr, Node* parent, Node*& root)
+	{
+		Node* tmp = nodePtr->left;
+		nodePtr->left = tmp->right;
+		tmp->right = nodePtr;
+		replaceChild(parent, nodePtr, tmp, root);
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	PersistentRBTree<TKey, TValue, TComp>
+		PersistentRBTree<TKey, TValue, TComp>::insert(const TKey& key, const TValue& value) const
+	{
+		// path holds private copies of the search path; path[i - 1] is the parent of path[i].
+		Node* path[maxHeight + 1];
+		int length = 0;
+
+		Node* newRoot = nullptr;
+		if (root != nullptr)
+		{
+			newRoot = new Node(root);
+			path[length++] = newRoot;
+
+			while (true)
+			{
+				Node* current = path[length - 1];
+				bool goLeft = comp(key, current->key());
+				Node* next = goLeft ? current->left : current->right;
+
+				if (next == nullptr)
+					break;
+
+				path[length++] = copyChild(current, goLeft);
+			}
+		}
+
+		Node* newNode = new Node(key, value);
+		if (length == 0)
+			newRoot = newNode;
+		else if (comp(key, path[length - 1]->key()))
+			path[length - 1]->left = newNode;
+		else
+			path[length - 1]->right = newNode;
+		path[length++] = newNode;
+
+		int i = length - 1;
+		while (i >= 2 && isRed(path[i - 1]))
+		{
+			Node* nodePtr = path[i];
+			Node* parent = path[i - 1];
+			Node* grandParent = path[i - 2];
+			Node* greatGrandParent = i >= 3 ? path[i - 3] : nullptr;
+
+			if (parent == grandParent->left)
+			{
+				if (isRed(grandParent->right))
+				{
+					// Case 1: recolour, the uncle has to be copied first.
+					Node* uncle = copyChild(grandParent, false);
+					parent->color = black;
+					uncle->color = black;
+					grandParent->color = red;
+					i -= 2;
+					continue;
+				}
+
+				if (nodePtr == parent->right)
+				{
+					// Case 2: turn into case 3.
+					rotateLeft(parent, grandParent, newRoot);
+					std::swap(path[i], path[i - 1]);
+					parent = path[i - 1];
+				}
+
+				// Case 3.
+				parent->color = black;
+				grandParent->color = red;
+				rotateRight(grandParent, greatGrandParent, newRoot);
+			}
+			else
+			{
+				if (isRed(grandParent->left))
+				{
+					Node* uncle = copyChild(grandParent, true);
+					parent->color = black;
+					uncle->color = black;
+					grandParent->color = red;
+					i -= 2;
+					continue;
+				}
+
+				if (nodePtr == parent->left)
+				{
+					rotateRight(parent, grandParent, newRoot);
+					std::swap(path[i], path[i - 1]);
+					parent = path[i - 1];
+				}
+
+				parent->color = black;
+				grandParent->color = red;
+				rotateLeft(grandParent, greatGrandParent, newRoot);
+			}
+
+			break;
+		}
+
+		newRoot->color = black;
+		return PersistentRBTree(comp, newRoot, count + 1);
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	PersistentRBTree<TKey, TValue, TComp>
+		PersistentRBTree<TKey, TValue, TComp>::remove(const TKey& key) const
+	{
+		if (findNode(key) == nullptr)
+			return *this;
+
+		Node* path[maxHeight + 1];
+		int length = 0;
+
+		Node* newRoot = new Node(root);
+		path[length++] = newRoot;
+
+		// Copy the path down to the node holding the key...
+		while (comp(key, path[length - 1]->key()) || comp(path[length - 1]->key(), key))
+		{
+			Node* current = path[length - 1];
+			path[length++] = copyChild(current, comp(key, current->key()));
+		}
+
+		// ...and, if it has two children, on to its successor, whose entry takes its place.
+		Node* z = path[length - 1];
+		if (z->left != nullptr && z->right != nullptr)
+		{
+			Node* ptr = copyChild(z, false);
+			path[length++] = ptr;
+
+			while (ptr->left != nullptr)
+			{
+				ptr = copyChild(ptr, true);
+				path[length++] = ptr;
+			}
+
+			z->keyValue = path[length - 1]->keyValue;
+		}
+
+		// The node to unlink now has at most one child, which moves up to its parent.
+		Node* y = path[--length];
+		Node* x = y->left != nullptr ? y->left : y->right;
+		Node* xParent = length > 0 ? path[length - 1] : nullptr;
+		bool yColor = y->color;
+
+		replaceChild(xParent, y, x, newRoot);
+		delete y;
+
+		if (yColor == black)
+		{
+			// x may be recoloured below, so it has to be private too.
+			if (x != nullptr && xParent == nullptr)
+			{
+				Node* copy = new Node(x);
+				x->refs.fetch_sub(1, std::memory_order_relaxed);
+				newRoot = x = copy;
+			}
+			else if (x != nullptr)
+			{
+				x = copyChild(xParent, xParent->left == x);
+			}
+
+			int parentIndex = length - 1;
+			while (parentIndex >= 0 && !isRed(x))
+			{
+				Node* parent = path[parentIndex];
+				Node* grandParent = parentIndex > 0 ? path[parentIndex - 1] : nullptr;
+
+				if (x == parent->left)
+				{
+					Node* w = copyChild(parent, false);
+					if (w->color == red)
+					{
+						// Case 1.
+						w->color = black;
+						parent->color = red;
+						rotateLeft(parent, grandParent, newRoot);
+
+						// w is now between grandParent and parent.
+						path[parentIndex] = w;
+						path[++parentIndex] = parent;
+						grandParent = w;
+						w = copyChild(parent, false);
+					}
+
+					if (!isRed(w->left) && !isRed(w->right))
+					{
+						// Case 2.
+						w->color = red;
+						x = parent;
+						parentIndex--;
+					}
+					else
+					{
+						Node* wRight;
+						if (!isRed(w->right))
+						{
+							// Case 3.
+							Node* wLeft = copyChild(w, true);
+							wLeft->color = black;
+							w->color = red;
+							rotateRight(w, parent, newRoot);
+							wRight = w;
+							w = wLeft;
+						}
+						else
+						{
+							wRight = copyChild(w, false);
+						}
+
+						// Case 4.
+						w->color = parent->color;
+						parent->color = black;
+						wRight->color = black;
+						rotateLeft(parent, grandParent, newRoot);
+						x = newRoot;
+						break;
+					}
+				}
+				else
+				{
+					Node* w = copyChild(parent, true);
+					if (w->color == red)
+					{
+						w->color = black;
+						parent->color = red;
+						rotateRight(parent, grandParent, newRoot);
+
+						path[parentIndex] = w;
+						path[++parentIndex] = parent;
+						grandParent = w;
+						w = copyChild(parent, true);
+					}
+
+					if (!isRed(w->right) && !isRed(w->left))
+					{
+						w->color = red;
+						x = parent;
+						parentIndex--;
+					}
+					else
+					{
+						Node* wLeft;
+						if (!isRed(w->left))
+						{
+							Node* wRight = copyChild(w, false);
+							wRight->color = black;
+							w->color = red;
+							rotateLeft(w, parent, newRoot);
+							wLeft = w;
+							w = wRight;
+						}
+						else
+						{
+							wLeft = copyChild(w, true);
+						}
+
+						w->color = parent->color;
+						parent->color = black;
+						wLeft->color = black;
+						rotateRight(parent, grandParent, newRoot);
+						x = newRoot;
+						break;
+					}
+				}
+			}
+
+			if (x != nullptr)
+				x->color = black;
+		}
+
+		if (newRoot != nullptr)
+			newRoot->color = black;
+
+		return PersistentRBTree(comp, newRoot, count - 1);
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	template <typename TLookup>
+	typename PersistentRBTree<TKey, TValue, TComp>::Node*
+		PersistentRBTree<TKey, TValue, TComp>::findNode(const TLookup& key) const
+	{
+		Node* ptr = root;
+
+		while (ptr != nullptr)
+		{
+			if (comp(key, ptr->key()))
+				ptr = ptr->left;
+			else if (comp(ptr->key(), key))
+				ptr = ptr->right;
+			else
+				break;
+		}
+
+		return ptr;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	const typename PersistentRBTree<TKey, TValue, TComp>::Node*
+		PersistentRBTree<TKey, TValue, TComp>::findMinNode(const Node* node)
+	{
+		while (node->left != nullptr)
+			node = node->left;
+
+		return node;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	const typename PersistentRBTree<TKey, TValue, TComp>::Node*
+		PersistentRBTree<TKey, TValue, TComp>::findMaxNode(const Node* node)
+	{
+		while (node->right != nullptr)
+			node = node->right;
+
+		return node;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	const TValue& PersistentRBTree<TKey, TValue, TComp>::find(const TKey& key) const
+	{
+		Node* ptr = findNode(key);
+
+		if (ptr == nullptr)
+			throw std::exception("Cannot find node");
+
+		return ptr->value();
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	std::pair<const TKey&, const TValue&> PersistentRBTree<TKey, TValue, TComp>::min() const
+	{
+		if (root == nullptr)
+			throw std::exception("Cannot find node");
+
+		const Node* minNode = findMinNode(root);
+		return std::pair<const TKey&, const TValue&>(minNode->key(), minNode->value());
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	std::pair<const TKey&, const TValue&> PersistentRBTree<TKey, TValue, TComp>::max() const
+	{
+		if (root == nullptr)
+			throw std::exception("Cannot find node");
+
+		const Node* maxNode = findMaxNode(root);
+		return std::pair<const TKey&, const TValue&>(maxNode->key(), maxNode->value());
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	const TKey& PersistentRBTree<TKey, TValue, TComp>::successor(const TKey& key) const
+	{
+		// No parent pointers: remember the last node where the search turned left.
+		const Node* candidate = nullptr;
+		const Node* ptr = root;
+
+		while (ptr != nullptr)
+		{
+			if (comp(key, ptr->key()))
+			{
+				candidate = ptr;
+				ptr = ptr->left;
+			}
+			else if (comp(ptr->key(), key))
+			{
+				ptr = ptr->right;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		if (ptr == nullptr)
+			throw std::exception("Cannot find node");
+
+		if (ptr->right != nullptr)
+			return findMinNode(ptr->right)->key();
+
+		if (candidate == nullptr)
+			throw std::exception("Cannot find successor");
+
+		return candidate->key();
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	const TKey& PersistentRBTree<TKey, TValue, TComp>::predecessor(const TKey& key) const
+	{
+		const Node* candidate = nullptr;
+		const Node* ptr = root;
+
+		while (ptr != nullptr)
+		{
+			if (comp(key, ptr->key()))
+			{
+				ptr = ptr->left;
+			}
+			else if (comp(ptr->key(), key))
+			{
+				candidate = ptr;
+				ptr = ptr->right;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		if (ptr == nullptr)
+			throw std::exception("Cannot find node");
+
+		if (ptr->left != nullptr)
+			return findMaxNode(ptr->left)->key();
+
+		if (candidate == nullptr)
+			throw std::exception("Cannot find predecessor");
+
+		return candidate->key();
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void PersistentRBTree<TKey, TValue, TComp>::print() const
+	{
+		const Node* stack[maxHeight];
+		int top = 0;
+		const Node* node = root;
+
+		while (node != nullptr || top > 0)
+		{
+			while (node != nullptr)
+			{
+				stack[top++] = node;
+				node = node->left;
+			}
+
+			node = stack[--top];
+			std::cout << node->key() << " (" << node->value() << ") ";
+			node = node->right;
+		}
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	size_t PersistentRBTree<TKey, TValue, TComp>::height() const
+	{
+		std::pair<const Node*, size_t> stack[maxHeight];
+		int top = 0;
+		size_t h = 0;
+
+		if (root != nullptr)
+			stack[top++] = std::make_pair(root, size_t(1));
+
+		while (top > 0)
+		{
+			const Node* node = stack[top - 1].first;
+			size_t depth = stack[--top].second;
+
+			// Follow left children inline and defer right ones: the stack never exceeds the height.
+			while (node != nullptr)
+			{
+				h = std::max(h, depth);
+
+				if (node->right != nullptr)
+					stack[top++] = std::make_pair(node->right, depth + 1);
+
+				node = node->left;
+				depth++;
+			}
+		}
+
+		return h;
+	}
+}
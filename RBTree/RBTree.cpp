@@ -2,19 +2,96 @@
 //
 
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+#include <random>
+#include <vector>
 #include "RBTree.h"
 #include "RBTreeVisuzlizer.h"
-#include <map>
-#include <random>
 #include "RandomizedBST.h"
 #include "RandomizedBSTVisualizer.h"
+#include "PersistentRBTree.h"
+#include "FlatMap.h"
+#include "IntervalTree.h"
+#include "ZipTree.h"
+#include "CompactRBTree.h"
+#include "SplayTree.h"
+#include "SnapshotView.h"
 
 using namespace std;
 
-int main()
+// Millions of lookups per second over the given key sequence.
+template <typename TTree>
+double measureLookups(const TTree& tree, const vector<int>& lookups)
+{
+	auto start = chrono::steady_clock::now();
+
+	size_t hits = 0;
+	for (int key : lookups)
+		hits += tree.contains(key);
+
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+	if (hits != lookups.size())
+		cout << "Missing keys" << endl;
+
+	return lookups.size() / elapsed.count() / 1e6;
+}
+
+// Compares RBTree and SplayTree on lookups whose popularity follows Zipf's law:
+// the key of rank r is drawn with probability proportional to 1 / r^skew.
+// Ranks are spread over the key space at random, so hot keys are not neighbours.
+// Run it with more keys than fit in the last-level cache to see the effect of misses.
+void benchmarkZipf(int keyCount)
 {
-	srand(NULL);
+	const size_t lookupCount = 1 << 22;
+
+	mt19937 rng(1);
+	vector<int> keys(keyCount);
+	iota(keys.begin(), keys.end(), 0);
+	shuffle(keys.begin(), keys.end(), rng);
+
+	algs::RBTree<int, int> rbTree;
+	algs::SplayTree<int, int> splayTree;
+	for (int key : keys)
+	{
+		rbTree.insert(key, key);
+		splayTree.insert(key, key);
+	}
+
+	cout << endl << "Mlookups/s, " << keyCount << " keys" << endl;
+	cout << setw(8) << "skew" << setw(10) << "RBTree" << setw(12) << "SplayTree" << endl;
 
+	for (double skew : { 0.0, 0.8, 0.99, 1.2 })
+	{
+		// Inverse transform sampling over the cumulative weights.
+		vector<double> cumulative(keyCount);
+		double total = 0;
+		for (int rank = 0; rank < keyCount; rank++)
+		{
+			total += 1 / pow(rank + 1.0, skew);
+			cumulative[rank] = total;
+		}
+
+		uniform_real_distribution<double> uniform(0, total);
+		vector<int> lookups(lookupCount);
+		for (auto& key : lookups)
+		{
+			size_t rank = upper_bound(cumulative.begin(), cumulative.end(), uniform(rng)) - cumulative.begin();
+			key = keys[min(rank, keys.size() - 1)];
+		}
+
+		cout << setw(8) << skew << fixed << setprecision(2)
+			<< setw(10) << measureLookups(rbTree, lookups)
+			<< setw(12) << measureLookups(splayTree, lookups) << endl;
+		cout.unsetf(ios_base::fixed);
+	}
+}
+
+int main()
+{
 	algs::RBTree<int, int> rb_tree;
 	
 	for (int x = 100; x > 0; x--)
@@ -25,6 +102,8 @@ int main()
 	algs::RBTreeVisualizer<int, int, less<int>> visualizer(rb_tree);
 	string filename = "rbTree.dot";
 	visualizer.saveDot(filename);
+	visualizer.saveDot("rbTreeTop.dot", 4);
+	visualizer.saveBinary("rbTree.bin");
 
 	cout << "RB Tree Height " << rb_tree.height() << endl;
 		
@@ -35,9 +114,60 @@ int main()
 
 	cout << "RB Tree Height " << rb_tree.height() << endl;
 
+	auto counters = rb_tree.counters();
+	cout << "Nodes " << counters.nodeCount << " black height " << counters.blackHeight
+		<< " deepest insert " << counters.maxInsertDepth << endl;
+
+	auto stats = algs::statsAsync(rb_tree).get();
+	cout << "Average depth " << stats.averageDepth << ", max depth " << stats.height << endl;
+
+	rb_tree.save("rbTree.snap");
+	algs::RBTree<int, int> restored;
+	restored.load("rbTree.snap");
+	algs::SnapshotView<int, int> mapped("rbTree.snap");
+	cout << "Restored " << restored.size() << " entries, height " << restored.height()
+		<< ", mapped find 42 " << mapped.find(42) << endl;
+
+	vector<pair<int, int>> batch;
+	for (int x = 200; x > 100; x--)
+		batch.push_back(make_pair(x, x));
+	rb_tree.insertBatch(batch.begin(), batch.end());
+
+	vector<int> lookups = { 10, 150, 300 };
+	vector<const int*> found;
+	cout << "Batch found " << rb_tree.findBatch(lookups.begin(), lookups.end(), back_inserter(found)) << " of " << lookups.size() << endl;
+	rb_tree.removeBatch(lookups.begin(), lookups.end());
+
+	auto frozen = algs::FlatMap<int, int>::freeze(rb_tree);
+	cout << "Frozen " << frozen.size() << " entries, successor of 25 is " << frozen.successor(25) << endl;
+
+	// std::less<> is transparent: lookups by string literal build no temporary std::string.
+	algs::RBTree<string, int, less<>> colors;
+	colors.insert("red", 1);
+	colors.insert("black", 2);
+	cout << "Find black " << colors.find("black") << endl;
+
+	algs::RBTree<int, int, less<int>, algs::SumAugment<int>> sums;
+	for (int x = 1; x <= 100; x++)
+		sums.insert(x, x);
+	sums.remove(50);
+	cout << "Sum of all " << sums.summary() << ", sum of [10, 20) " << sums.aggregate(10, 20) << endl;
+
+	algs::IntervalTree<int, string> bookings;
+	bookings.insert(9, 12, "standup");
+	bookings.insert(11, 15, "review");
+	bookings.insert(14, 18, "release");
+	bookings.insert(20, 21, "retro");
+	size_t overlapping = bookings.forEachOverlap(12, 14, [](int start, int end, const string& name)
+	{
+		cout << name << " [" << start << ", " << end << "] ";
+	});
+	cout << "overlap [12, 14]: " << overlapping << endl;
+
 	for (int k = 0; k < 2; k++)
 	{
-		algs::RandomizedBST<int, int> rnd_tree;
+		// Explicit seeds make every run build the same trees.
+		algs::RandomizedBST<int, int> rnd_tree(less<int>(), algs::WyRand(k + 1));
 		algs::RandomizedBSTVisualizer<int, int, less<int>> rnd_visualizer(rnd_tree);
 
 		for (int x = 100; x > 0; x--)
@@ -56,6 +186,47 @@ int main()
 		rnd_visualizer.saveDot(string("rndTree_delete") + to_string(k) + ".dot");
 		cout << "Randomized Tree Height " << rnd_tree.height() << endl;
 	}
+
+	algs::CompactRBTree<int, int> compact_tree;
+	compact_tree.reserve(100);
+	for (int x = 100; x > 0; x--)
+		compact_tree.insert(x, x);
+	cout << "Compact Tree " << compact_tree.bytesPerEntry() << " bytes per entry against "
+		<< rb_tree.counters().bytesPerNode << endl;
+	for (int x = 100; x > 50; x--)
+		compact_tree.remove(x);
+	cout << "Compact Tree Height " << compact_tree.height() << endl;
+
+	algs::ZipTree<int, int> zip_tree;
+	for (int x = 100; x > 0; x--)
+		zip_tree.insert(x, x);
+	for (int x = 100; x > 50; x--)
+		zip_tree.remove(x);
+	cout << "Zip Tree Height " << zip_tree.height() << ", successor of 25 is " << zip_tree.successor(25) << endl;
+
+	algs::PersistentRBTree<int, int> version;
+	for (int x = 100; x > 0; x--)
+	{
+		version = version.insert(x, x);
+	}
+
+	algs::PersistentRBTree<int, int> snapshot = version;
+	for (int x = 100; x > 50; x--)
+	{
+		version = version.remove(x);
+	}
+
+	cout << "Persistent Tree Size " << version.size() << ", snapshot size " << snapshot.size()
+		<< ", snapshot max " << snapshot.max().first << endl;
+
+	algs::SplayTree<int, int> splay_tree;
+	for (int x = 100; x > 0; x--)
+		splay_tree.insert(x, x);
+	splay_tree.find(1);
+	cout << "Splay Tree Height " << splay_tree.height() << ", predecessor of 50 is " << splay_tree.predecessor(50) << endl;
+
+	benchmarkZipf(1 << 18);
+	benchmarkZipf(1 << 23);
 	
 	return 0;
 }
@@ -11,90 +11,167 @@
 #include <iostream>
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "TreeAugment.h"
+#include "TreeStats.h"
+#include "TreeSnapshot.h"
+
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif
 
 namespace algs {
 
 	template <
 		typename TKey1,
 		typename TValue1,
-		typename TComp1
+		typename TComp1,
+		typename TAugment1
 	>
 	class RBTreeVisualizer;
 
+	template <
+		typename TPoint1,
+		typename TValue1,
+		typename TComp1
+	>
+	class IntervalTree;
+
+	// TAugment adds a subtree summary to every node, see TreeAugment.h.
 	template <
 		typename TKey,
 		typename TValue,
-		typename TComp = std::less<TKey>
+		typename TComp = std::less<TKey>,
+		typename TAugment = NoAugment
 	>
 	class RBTree
 	{
 		static constexpr bool black = false;
 		static constexpr bool red = true;
 
+		// Batches of at least count / relinkRatio entries rebuild the tree in O(n + m)
+		// instead of paying O(log n) per entry.
+		static constexpr size_t relinkRatio = 2;
+
+		// Number of searches locate() runs side by side.
+		static constexpr size_t lanes = 8;
+
+		static constexpr bool augmented = !std::is_same<TAugment, NoAugment>::value;
+
 		template <
 			typename TKey1,
 			typename TValue1,
-			typename TComp1
+			typename TComp1,
+			typename TAugment1
 		>
 		friend class RBTreeVisualizer;
+
+		template <
+			typename TPoint1,
+			typename TValue1,
+			typename TComp1
+		>
+		friend class IntervalTree;
 		
+	public:
+		typedef typename TAugment::Summary Summary;
+
 	private:
-		struct Node
+		// Nodes keep the colour in the lowest bit of the parent pointer, which is
+		// always zero for an aligned Node, and the subtree summary in an empty base
+		// when there is none: an int -> int node takes 32 bytes instead of 40.
+		struct Node : SummaryField<Summary>
 		{
-			Node* parent;
 			Node* left;
 			Node* right;
 
 			std::pair<TKey, TValue> keyValue;
 
-			bool color;
-
 			Node() :
-				parent(nullptr),
 				left(nullptr),
 				right(nullptr),
 				keyValue(std::pair<TKey, TValue>()),
-				color(red)
+				parentColor(red)
 			{
 			}
 
 			Node(const TKey& key, const TValue& value) :
-				parent(nullptr),
 				left(nullptr),
 				right(nullptr),
 				keyValue(std::make_pair(key, value)),
-				color(red)
+				parentColor(red)
 			{
 			}
 
-			TKey key() const { return keyValue.first; }
+			Node* parent() const { return reinterpret_cast<Node*>(parentColor & ~uintptr_t(1)); }
+
+			void setParent(Node* node) { parentColor = reinterpret_cast<uintptr_t>(node) | (parentColor & 1); }
+
+			bool color() const { return (parentColor & 1) != 0; }
+
+			void setColor(bool color) { parentColor = (parentColor & ~uintptr_t(1)) | (color ? 1 : 0); }
+
+			const TKey& key() const { return keyValue.first; }
+
+			TValue& value() { return keyValue.second; }
 
-			TValue value() const { return keyValue.second; }			
+			const TValue& value() const { return keyValue.second; }
+
+		private:
+			uintptr_t parentColor;
 		};
 
 	public:
 		explicit RBTree() :
 			comp(),
+			augment(),
 			root(nullptr),
-			sentinel(new Node)
+			sentinel(new Node),
+			count(0),
+			lastInsertDepth(0),
+			maxInsertDepth(0)
 		{
 			sentinel->left =
-				sentinel->right =
-				sentinel->parent = sentinel;
-			sentinel->color = black;
+				sentinel->right = sentinel;
+			sentinel->setParent(sentinel);
+			sentinel->setColor(black);
 
 			root = sentinel;
 		}
 
 		explicit RBTree(const TComp& comp) :
 			comp(comp),
+			augment(),
+			root(nullptr),
+			sentinel(new Node),
+			count(0),
+			lastInsertDepth(0),
+			maxInsertDepth(0)
+		{
+			sentinel->left =
+				sentinel->right = sentinel;
+			sentinel->setParent(sentinel);
+			sentinel->setColor(black);
+
+			root = sentinel;
+		}
+
+		explicit RBTree(const TComp& comp, const TAugment& augment) :
+			comp(comp),
+			augment(augment),
 			root(nullptr),
-			sentinel(new Node)
+			sentinel(new Node),
+			count(0),
+			lastInsertDepth(0),
+			maxInsertDepth(0)
 		{
 			sentinel->left =
-				sentinel->right =
-				sentinel->parent = sentinel;
-			sentinel->color = black;
+				sentinel->right = sentinel;
+			sentinel->setParent(sentinel);
+			sentinel->setColor(black);
 
 			root = sentinel;
 		}
@@ -107,55 +184,317 @@ namespace algs {
 
 		const TValue& find(const TKey& key) const;
 
-		std::pair<TKey&, TValue&> min() const;
+		// Lookup by any type the comparator can compare with TKey, e.g. std::less<>
+		// lets a tree of std::string be searched with a string literal or string_view
+		// without building a temporary key.
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		const TValue& find(const TLookup& key) const
+		{
+			Node* ptr = findNode(key);
+
+			if (ptr == sentinel)
+				throw std::exception("Cannot find node");
+
+			return ptr->value();
+		}
+
+		bool contains(const TKey& key) const
+		{
+			return findNode(key) != sentinel;
+		}
 
-		std::pair<TKey&, TValue&> max() const;
+		// Value of an entry with key, or nullptr if there is none: one search where
+		// contains() and find() take two.
+		const TValue* tryFind(const TKey& key) const
+		{
+			Node* ptr = findNode(key);
+			return ptr == sentinel ? nullptr : &ptr->value();
+		}
 
-		TKey& successor(const TKey& key) const;
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		bool contains(const TLookup& key) const
+		{
+			return findNode(key) != sentinel;
+		}
 
-		TKey& predecessor(const TKey& key) const;
+		std::pair<const TKey&, TValue&> min() const;
+
+		std::pair<const TKey&, TValue&> max() const;
+
+		const TKey& successor(const TKey& key) const;
+
+		const TKey& predecessor(const TKey& key) const;
 
 		void insert(const TKey& key, const TValue& value);
 
+		// Overwrites the value of an entry with key in place, or inserts one if there is
+		// none, in a single search.
+		void insertOrAssign(const TKey& key, const TValue& value);
+
 		void remove(const TKey& key);
 
+		// Inserts a range of key/value pairs. The batch is sorted first. A batch that is
+		// large next to the tree is merged with it in one O(n + m) pass and the nodes
+		// are relinked into a balanced tree. A smaller one is inserted in key order,
+		// each search starting from the previously inserted node (finger search).
+		template <typename TIterator>
+		void insertBatch(TIterator first, TIterator last);
+
+		// Looks up a range of keys in groups, moving every lookup of a group one level
+		// down per round and prefetching the next nodes, so their cache misses overlap.
+		// Writes a const TValue* for each key, nullptr if it is missing, to out in batch
+		// order and returns the number of keys found. The range must yield references
+		// to stored keys.
+		template <typename TIterator, typename TOutput>
+		size_t findBatch(TIterator first, TIterator last, TOutput out) const;
+
+		// Removes one entry per key in the range, like calling remove() for each.
+		// Large batches are filtered out in one O(n + m) pass and the tree is relinked,
+		// smaller ones are removed in key order.
+		template <typename TIterator>
+		void removeBatch(TIterator first, TIterator last);
+
 		void print() const
 		{
 			print(root);
 		}
 
+		size_t size() const
+		{
+			return count;
+		}
+
+		// Summary of all entries, read off the root.
+		const Summary& summary() const
+		{
+			static_assert(augmented, "summary() needs an augmented tree");
+
+			if (root == sentinel)
+				throw std::exception("Cannot find node");
+
+			return root->summary;
+		}
+
+		// Summary of the entries with keys in [from, to), e.g. the sum of their values
+		// with SumAugment, combined from O(log n) stored subtree summaries.
+		Summary aggregate(const TKey& from, const TKey& to) const;
+
+		// Calls visit(key, value) for every entry in key order.
+		template <typename TFunc>
+		void forEach(TFunc visit) const
+		{
+			if (root == sentinel)
+				return;
+
+			for (Node* ptr = findMinNode(root); ptr != sentinel; ptr = nextNode(ptr))
+				visit(ptr->key(), ptr->value());
+		}
+
+		// Calls visit(key, value) for every entry with from <= key < to, in order.
+		// Returns the number of entries visited.
+		template <typename TFunc>
+		size_t range(const TKey& from, const TKey& to, TFunc visit) const
+		{
+			// Lowest node not below from.
+			Node* first = sentinel;
+
+			for (Node* node = root; node != sentinel; )
+			{
+				if (comp(node->key(), from))
+				{
+					node = node->right;
+				}
+				else
+				{
+					first = node;
+					node = node->left;
+				}
+			}
+
+			size_t visited = 0;
+
+			for (Node* ptr = first; ptr != sentinel && comp(ptr->key(), to); ptr = nextNode(ptr))
+			{
+				visit(ptr->key(), ptr->value());
+				visited++;
+			}
+
+			return visited;
+		}
+
 		size_t height() const
 		{
-			return height(this->root);
+			size_t h = 0;
+			walk([&h](const Node*, size_t depth) { h = std::max(h, depth); }, [](Node*) { });
+			return h;
+		}
+
+		TreeCounters counters() const
+		{
+			TreeCounters result = TreeCounters();
+			result.nodeCount = count;
+			result.lastInsertDepth = lastInsertDepth;
+			result.maxInsertDepth = maxInsertDepth;
+			result.blackHeight = blackHeight();
+			result.bytesPerNode = sizeof(Node);
+			return result;
+		}
+
+		// O(n), see statsAsync() to run it off the calling thread.
+		TreeStats stats() const;
+
+		// Writes the entries to a binary snapshot, see TreeSnapshot.h.
+		void save(const std::string& fileName) const
+		{
+			snapshot::write<TKey, TValue>(fileName, *this);
+		}
+
+		// Replaces the contents with a snapshot, rebuilt bottom-up in O(n)
+		// instead of one insert per entry. The snapshot goes into a separate tree
+		// that is swapped in once complete, so on an exception the contents stay
+		// as they were and the separate tree frees what it holds.
+		void load(const std::string& fileName)
+		{
+			std::vector<TKey> keys;
+			std::vector<TValue> values;
+			snapshot::read(fileName, keys, values);
+
+			RBTree loaded(comp, augment);
+			loaded.build(keys.data(), values.data(), keys.size());
+
+			std::swap(root, loaded.root);
+			std::swap(sentinel, loaded.sentinel);
+			std::swap(count, loaded.count);
+			lastInsertDepth = 0;
+			maxInsertDepth = 0;
 		}
 
 	private:
 		bool static isRed(const Node* node)
 		{
 			if (node == nullptr) return false;
-			return node->color;
+			return node->color();
 		}
 
 		void clean(Node* node)
 		{
-			if (node == sentinel)
-				return;
-
-			clean(node->left);
-			clean(node->right);
-
-			delete node;
+			// Rotate left children up until the tree is a right-leaning list,
+			// deleting nodes as they reach the head of the list.
+			while (node != sentinel)
+			{
+				if (node->left != sentinel)
+				{
+					Node* child = node->left;
+					node->left = child->right;
+					child->right = node;
+					node = child;
+				}
+				else
+				{
+					Node* next = node->right;
+					delete node;
+					node = next;
+				}
+			}
 		}
 
 		Node* findMinNode(Node* node) const;
 
 		Node* findMaxNode(Node* node) const;
 
-		Node* findNode(const TKey& key) const;
+		template <typename TLookup>
+		Node* findNode(const TLookup& key) const;
+
+		Node* nextNode(Node* node) const;
 
 		void print(Node* nodePtr) const;
 
-		void insertFixup(Node* nodePtr);
+		size_t blackHeight() const
+		{
+			size_t h = 0;
+
+			for (Node* ptr = root; ptr != sentinel; ptr = ptr->left)
+			{
+				if (ptr->color() == black)
+					h++;
+			}
+
+			return h;
+		}
+
+		void build(const TKey* keys, const TValue* values, size_t n);
+
+		// Recomputes the summary of node from its entry and its children's summaries.
+		void refresh(Node* node)
+		{
+			if (!augmented)
+				return;
+
+			Summary summary = augment.entry(node->key(), node->value());
+
+			if (node->left != sentinel)
+				summary = augment.combine(node->left->summary, summary);
+
+			if (node->right != sentinel)
+				summary = augment.combine(summary, node->right->summary);
+
+			node->summary = summary;
+		}
+
+		// Refreshes node and all of its ancestors.
+		void refreshPath(Node* node)
+		{
+			if (!augmented)
+				return;
+
+			for (; node != sentinel; node = node->parent())
+				refresh(node);
+		}
+
+		// Refreshes every node, children before parents.
+		void refreshAll();
+
+		// Depth-first walk over parent pointers: no recursion and no auxiliary storage.
+		// Calls enter(node, depth) when the walk first reaches a node, the root at depth 1,
+		// and leave(node) when it goes back up to the parent, after both subtrees.
+		template <typename TEnter, typename TLeave>
+		void walk(TEnter enter, TLeave leave) const;
+
+		// Links make(0) ... make(n - 1), in key order, into a balanced tree. Returns its
+		// height.
+		template <typename TMake>
+		size_t assemble(size_t n, TMake make);
+
+		// Links a new node below parent, found by a search for its key, and rebalances.
+		// Returns the number of levels the rotations lifted the new node by.
+		size_t attach(Node* newNode, Node* parent);
+
+		void removeNode(Node* z);
+
+		// Searches for keys[0] ... keys[n - 1] together, moving every search one level
+		// down per round and prefetching the next nodes, so their cache misses overlap.
+		// nodes[i] receives the node with keys[i] or the sentinel.
+		void locate(const TKey** keys, Node** nodes, size_t n) const;
+
+		static void prefetch(const Node* node)
+		{
+#ifdef _MSC_VER
+			_mm_prefetch(reinterpret_cast<const char*>(node), _MM_HINT_T0);
+#else
+			__builtin_prefetch(node);
+#endif
+		}
+
+		// Returns the number of levels the rotations lifted nodePtr by.
+		size_t insertFixup(Node* nodePtr);
 
 		void removeFixup(Node *nodePtr);
 
@@ -165,22 +504,19 @@ namespace algs {
 
 		void transplant(Node * prevNode, Node * newNode);
 
-		size_t height(Node * nodePtr) const
-		{
-			if (nodePtr == sentinel)
-				return 0;
-			return 1 + std::max(height(nodePtr->left), height(nodePtr->right));
-		}
-
 	private:
 		TComp comp;
+		TAugment augment;
 		Node * root;
 		Node * sentinel;
+		size_t count;
+		size_t lastInsertDepth;
+		size_t maxInsertDepth;
 
 	};
 
-	template <typename TKey, typename TValue, typename TComp>
-	const TValue& RBTree<TKey, TValue, TComp>::find(const TKey& key) const
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	const TValue& RBTree<TKey, TValue, TComp, TAugment>::find(const TKey& key) const
 	{
 		Node* ptr = findNode(key);
 
@@ -190,47 +526,35 @@ namespace algs {
 		return ptr->value();
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	std::pair<TKey&, TValue&> RBTree<TKey, TValue, TComp>::min() const
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	std::pair<const TKey&, TValue&> RBTree<TKey, TValue, TComp, TAugment>::min() const
 	{
 		Node* minNode = findMinNode(this->root);
 		if (minNode == sentinel)
 			throw std::exception("Cannot find node");
 
-		return std::make_pair(minNode->key(), minNode->value());
+		return std::pair<const TKey&, TValue&>(minNode->key(), minNode->value());
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	std::pair<TKey&, TValue&> RBTree<TKey, TValue, TComp>::max() const
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	std::pair<const TKey&, TValue&> RBTree<TKey, TValue, TComp, TAugment>::max() const
 	{
 		Node* maxNode = findMaxNode(this->root);
 		if (maxNode == sentinel)
 			throw std::exception("Cannot find node");
 
-		return std::make_pair(maxNode->key(), maxNode->value());
+		return std::pair<const TKey&, TValue&>(maxNode->key(), maxNode->value());
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	TKey& RBTree<TKey, TValue, TComp>::successor(const TKey& key) const
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	const TKey& RBTree<TKey, TValue, TComp, TAugment>::successor(const TKey& key) const
 	{
 		Node* keyNode = findNode(key);
 
 		if (keyNode == sentinel)
 			throw std::exception("Cannot find node");
 
-		if (keyNode->right != sentinel)
-		{
-			Node* ptr = findMinNode(keyNode->right);
-			return ptr->key();
-		}
-
-		Node* ptr = keyNode->parent;
-
-		while (ptr != sentinel && keyNode == ptr->right)
-		{
-			keyNode = ptr;
-			ptr = ptr->parent;
-		}
+		Node* ptr = nextNode(keyNode);
 
 		if (ptr == sentinel)
 			throw std::exception("Cannot find successor");
@@ -238,8 +562,8 @@ namespace algs {
 		return ptr->key();
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	TKey& RBTree<TKey, TValue, TComp>::predecessor(const TKey& key) const
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	const TKey& RBTree<TKey, TValue, TComp, TAugment>::predecessor(const TKey& key) const
 	{
 		Node* keyNode = findNode(key);
 
@@ -252,12 +576,12 @@ namespace algs {
 			return ptr->key();
 		}
 
-		Node* ptr = keyNode->parent;
+		Node* ptr = keyNode->parent();
 
 		while (ptr != sentinel && keyNode == ptr->left)
 		{
 			keyNode = ptr;
-			ptr = ptr->parent;
+			ptr = ptr->parent();
 		}
 
 		if (ptr == sentinel)
@@ -266,18 +590,19 @@ namespace algs {
 		return ptr->key();
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	void RBTree<TKey, TValue, TComp>::insert(const TKey& key, const TValue& value)
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	void RBTree<TKey, TValue, TComp, TAugment>::insert(const TKey& key, const TValue& value)
 	{
 		Node * newNode = new Node(key, value);
-		newNode->left = newNode->right = sentinel;
 
 		Node *tmp = sentinel;
 		Node *current = root;
+		size_t depth = 1;
 
 		while (current != sentinel)
 		{
 			tmp = current;
+			depth++;
 
 			if (this->comp(key, current->key()))
 			{
@@ -289,32 +614,544 @@ namespace algs {
 			}
 		}
 
-		newNode->parent = tmp;
-		if (tmp == sentinel)
+		attach(newNode, tmp);
+
+		lastInsertDepth = depth;
+		maxInsertDepth = std::max(maxInsertDepth, depth);
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	void RBTree<TKey, TValue, TComp, TAugment>::insertOrAssign(const TKey& key, const TValue& value)
+	{
+		Node *tmp = sentinel;
+		Node *current = root;
+		size_t depth = 1;
+
+		while (current != sentinel)
+		{
+			if (comp(key, current->key()))
+			{
+				tmp = current;
+				current = current->left;
+			}
+			else if (comp(current->key(), key))
+			{
+				tmp = current;
+				current = current->right;
+			}
+			else
+			{
+				current->value() = value;
+				refreshPath(current);
+				return;
+			}
+
+			depth++;
+		}
+
+		attach(new Node(key, value), tmp);
+
+		lastInsertDepth = depth;
+		maxInsertDepth = std::max(maxInsertDepth, depth);
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	void RBTree<TKey, TValue, TComp, TAugment>::build(const TKey* keys, const TValue* values, size_t n)
+	{
+		assemble(n, [keys, values](size_t index)
+		{
+			return new Node(keys[index], values[index]);
+		});
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	template <typename TMake>
+	size_t RBTree<TKey, TValue, TComp, TAugment>::assemble(size_t n, TMake make)
+	{
+		// Splitting every range at its middle puts all leaves on the last two levels.
+		// Colouring the last level red when it is incomplete, and everything else
+		// black, gives every path the same black-height.
+		size_t h = 0;
+		while (h < 64 && (size_t(1) << h) - 1 < n)
+			h++;
+
+		bool complete = h == 64 || (size_t(1) << h) - 1 == n;
+
+		struct Range
+		{
+			size_t from;
+			size_t to;
+			Node* parent;
+			Node** link;
+			size_t depth;
+		};
+
+		Range stack[130];
+		size_t top = 0;
+		stack[top++] = Range{ 0, n, sentinel, &root, 1 };
+
+		while (top > 0)
+		{
+			Range range = stack[--top];
+
+			if (range.from == range.to)
+			{
+				*range.link = sentinel;
+				continue;
+			}
+
+			size_t middle = range.from + (range.to - range.from) / 2;
+
+			// Children point at the sentinel until their ranges are built, so the
+			// tree stays whole if a later make() throws.
+			Node* node = make(middle);
+			node->left = node->right = sentinel;
+			node->setParent(range.parent);
+			node->setColor(range.depth == h && !complete ? red : black);
+			*range.link = node;
+
+			stack[top++] = Range{ middle + 1, range.to, node, &node->right, range.depth + 1 };
+			stack[top++] = Range{ range.from, middle, node, &node->left, range.depth + 1 };
+		}
+
+		count = n;
+
+		if (augmented)
+			refreshAll();
+
+		return h;
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	size_t RBTree<TKey, TValue, TComp, TAugment>::attach(Node* newNode, Node* parent)
+	{
+		newNode->left = newNode->right = sentinel;
+		newNode->setParent(parent);
+
+		if (parent == sentinel)
 		{
 			root = newNode;
 		}
-		else if (comp(key, tmp->key()))
+		else if (comp(newNode->key(), parent->key()))
 		{
-			tmp->left = newNode;
+			parent->left = newNode;
 		}
 		else
 		{
-			tmp->right = newNode;
+			parent->right = newNode;
 		}
 
-		insertFixup(newNode);
+		// Rotations below refresh the nodes they move, the rest of the path is done here.
+		refreshPath(newNode);
+		size_t lift = insertFixup(newNode);
+		count++;
+
+		return lift;
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	void RBTree<TKey, TValue, TComp>::remove(const TKey& key)
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	template <typename TIterator>
+	void RBTree<TKey, TValue, TComp, TAugment>::insertBatch(TIterator first, TIterator last)
 	{
-		Node *z = findNode(key);
-		if (z == sentinel)
+		// The entries are sorted before any node exists, and nodes are then allocated
+		// in key order, so neighbours in the tree tend to be neighbours in memory.
+		std::vector<std::pair<TKey, TValue>> entries;
+		for (; first != last; ++first)
+			entries.push_back(std::pair<TKey, TValue>(first->first, first->second));
+
+		std::stable_sort(entries.begin(), entries.end(), [this](const std::pair<TKey, TValue>& left, const std::pair<TKey, TValue>& right)
+		{
+			return comp(left.first, right.first);
+		});
+
+		if (entries.empty())
+			return;
+
+		if (entries.size() >= count / relinkRatio)
+		{
+			// Owned here until relinked, so an exception from an allocation or from
+			// comp frees the nodes not yet in the tree.
+			std::vector<std::unique_ptr<Node>> batch;
+			batch.reserve(entries.size());
+			for (const auto& entry : entries)
+				batch.push_back(std::unique_ptr<Node>(new Node(entry.first, entry.second)));
+
+			// Merge the batch into the existing nodes. On equal keys the batch
+			// entry goes last, as with insert().
+			std::vector<Node*> nodes;
+			nodes.reserve(count + batch.size());
+
+			Node* ptr = root == sentinel ? sentinel : findMinNode(root);
+			for (const auto& newNode : batch)
+			{
+				for (; ptr != sentinel && !comp(newNode->key(), ptr->key()); ptr = nextNode(ptr))
+					nodes.push_back(ptr);
+
+				nodes.push_back(newNode.get());
+			}
+
+			for (; ptr != sentinel; ptr = nextNode(ptr))
+				nodes.push_back(ptr);
+
+			for (auto& newNode : batch)
+				newNode.release();
+
+			// No node ends up deeper than the height of the relinked tree.
+			size_t h = assemble(nodes.size(), [&nodes](size_t index)
+			{
+				return nodes[index];
+			});
+
+			lastInsertDepth = h;
+			maxInsertDepth = std::max(maxInsertDepth, h);
+			return;
+		}
+
+		Node* finger = sentinel;
+		size_t fingerDepth = 0;
+
+		for (const auto& entry : entries)
+		{
+			Node* parent = sentinel;
+			Node* current = root;
+
+			// Depth of current, kept up to date on the way so the new node's depth is
+			// known without a walk back to the root.
+			size_t depth = 1;
+
+			// The key is not less than the finger's: climb while it is not less than the
+			// parent's either. Where the climb stops the key is below the parent, so it
+			// belongs in the current subtree.
+			if (finger != sentinel)
+			{
+				current = finger;
+				depth = fingerDepth;
+
+				while (current->parent() != sentinel && !comp(entry.first, current->parent()->key()))
+				{
+					current = current->parent();
+					depth--;
+				}
+
+				parent = current->parent();
+			}
+
+			while (current != sentinel)
+			{
+				parent = current;
+				current = comp(entry.first, current->key()) ? current->left : current->right;
+				depth++;
+			}
+
+			// attach() compares before it links, so the node is owned here until it returns.
+			std::unique_ptr<Node> newNode(new Node(entry.first, entry.second));
+			size_t lift = attach(newNode.get(), parent);
+			finger = newNode.release();
+			fingerDepth = depth - lift;
+
+			lastInsertDepth = depth;
+			maxInsertDepth = std::max(maxInsertDepth, depth);
+		}
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	void RBTree<TKey, TValue, TComp, TAugment>::locate(const TKey** keys, Node** nodes, size_t n) const
+	{
+		bool done[lanes];
+
+		for (size_t lane = 0; lane < n; ++lane)
+		{
+			nodes[lane] = root;
+			done[lane] = root == sentinel;
+		}
+
+		for (size_t active = n; active > 0; )
+		{
+			active = 0;
+
+			for (size_t lane = 0; lane < n; ++lane)
+			{
+				if (done[lane])
+					continue;
+
+				Node* node = nodes[lane];
+
+				if (comp(*keys[lane], node->key()))
+					node = node->left;
+				else if (comp(node->key(), *keys[lane]))
+					node = node->right;
+				else
+				{
+					done[lane] = true;
+					continue;
+				}
+
+				prefetch(node);
+				nodes[lane] = node;
+				done[lane] = node == sentinel;
+				active++;
+			}
+		}
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	template <typename TIterator, typename TOutput>
+	size_t RBTree<TKey, TValue, TComp, TAugment>::findBatch(TIterator first, TIterator last, TOutput out) const
+	{
+		const TKey* keys[lanes];
+		Node* nodes[lanes];
+		size_t found = 0;
+
+		while (first != last)
+		{
+			size_t n = 0;
+			for (; n < lanes && first != last; ++n, ++first)
+				keys[n] = &*first;
+
+			locate(keys, nodes, n);
+
+			for (size_t lane = 0; lane < n; ++lane)
+			{
+				const TValue* value = nullptr;
+				if (nodes[lane] != sentinel)
+				{
+					value = &nodes[lane]->value();
+					found++;
+				}
+
+				*out++ = value;
+			}
+		}
+
+		return found;
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	template <typename TIterator>
+	void RBTree<TKey, TValue, TComp, TAugment>::removeBatch(TIterator first, TIterator last)
+	{
+		std::vector<TKey> batch(first, last);
+		std::sort(batch.begin(), batch.end(), [this](const TKey& left, const TKey& right)
+		{
+			return comp(left, right);
+		});
+
+		if (batch.empty() || root == sentinel)
+			return;
+
+		if (batch.size() < count / relinkRatio)
+		{
+			// Find each group of keys side by side. Removing a node leaves every other
+			// node in place, so the results stay valid while the group is removed.
+			// Repeated keys find the same node and go through remove() instead.
+			const TKey* keys[lanes];
+			Node* nodes[lanes];
+
+			for (size_t position = 0; position < batch.size(); position += lanes)
+			{
+				size_t n = batch.size() - position < lanes ? batch.size() - position : lanes;
+				for (size_t lane = 0; lane < n; ++lane)
+					keys[lane] = &batch[position + lane];
+
+				locate(keys, nodes, n);
+
+				for (size_t lane = 0; lane < n; ++lane)
+				{
+					if (lane > 0 && !comp(*keys[lane - 1], *keys[lane]))
+						remove(*keys[lane]);
+					else if (nodes[lane] != sentinel)
+						removeNode(nodes[lane]);
+				}
+			}
+
 			return;
+		}
+
+		std::vector<Node*> nodes;
+		nodes.reserve(count);
+		for (Node* ptr = findMinNode(root); ptr != sentinel; ptr = nextNode(ptr))
+			nodes.push_back(ptr);
+
+		size_t kept = 0;
+		size_t index = 0;
+
+		for (size_t position = 0; position < nodes.size(); ++position)
+		{
+			Node* node = nodes[position];
 
+			while (index < batch.size() && comp(batch[index], node->key()))
+				index++;
+
+			if (index < batch.size() && !comp(node->key(), batch[index]))
+			{
+				delete node;
+				index++;
+			}
+			else
+			{
+				nodes[kept++] = node;
+			}
+		}
+
+		assemble(kept, [&nodes](size_t index)
+		{
+			return nodes[index];
+		});
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	TreeStats RBTree<TKey, TValue, TComp, TAugment>::stats() const
+	{
+		TreeStats result = TreeStats();
+		result.nodeCount = count;
+		result.blackHeight = blackHeight();
+		result.bytesPerNode = sizeof(Node);
+
+		if (root == sentinel)
+			return result;
+
+		size_t depthSum = 0;
+		walk([&result, &depthSum](const Node*, size_t depth)
+		{
+			if (result.depthHistogram.size() < depth)
+				result.depthHistogram.resize(depth);
+
+			result.depthHistogram[depth - 1]++;
+			depthSum += depth;
+		}, [](Node*) { });
+
+		result.height = result.depthHistogram.size();
+		result.averageDepth = static_cast<double>(depthSum) / count;
+		return result;
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	typename RBTree<TKey, TValue, TComp, TAugment>::Summary
+		RBTree<TKey, TValue, TComp, TAugment>::aggregate(const TKey& from, const TKey& to) const
+	{
+		static_assert(augmented, "aggregate() needs an augmented tree");
+
+		// The highest node inside the range splits it: what is left of the node lies in
+		// its left subtree, above from, and what is right of it in its right subtree, below to.
+		Node* split = root;
+
+		while (split != sentinel)
+		{
+			if (comp(split->key(), from))
+				split = split->right;
+			else if (!comp(split->key(), to))
+				split = split->left;
+			else
+				break;
+		}
+
+		if (split == sentinel)
+			throw std::exception("Cannot find node");
+
+		Summary result = augment.entry(split->key(), split->value());
+
+		// Every node of the left part that is not below from comes with its whole
+		// right subtree. Summaries are prepended, as the walk goes right to left.
+		for (Node* node = split->left; node != sentinel; )
+		{
+			if (comp(node->key(), from))
+			{
+				node = node->right;
+				continue;
+			}
+
+			if (node->right != sentinel)
+				result = augment.combine(node->right->summary, result);
+
+			result = augment.combine(augment.entry(node->key(), node->value()), result);
+			node = node->left;
+		}
+
+		// Mirror image for the right part.
+		for (Node* node = split->right; node != sentinel; )
+		{
+			if (!comp(node->key(), to))
+			{
+				node = node->left;
+				continue;
+			}
+
+			if (node->left != sentinel)
+				result = augment.combine(result, node->left->summary);
+
+			result = augment.combine(result, augment.entry(node->key(), node->value()));
+			node = node->right;
+		}
+
+		return result;
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	void RBTree<TKey, TValue, TComp, TAugment>::refreshAll()
+	{
+		walk([](const Node*, size_t) { }, [this](Node* node) { refresh(node); });
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	template <typename TEnter, typename TLeave>
+	void RBTree<TKey, TValue, TComp, TAugment>::walk(TEnter enter, TLeave leave) const
+	{
+		size_t depth = 1;
+		Node* prev = sentinel;
+		Node* node = root;
+
+		while (node != sentinel)
+		{
+			Node* next;
+
+			if (prev == node->parent())
+			{
+				enter(node, depth);
+
+				if (node->left != sentinel)
+					next = node->left;
+				else if (node->right != sentinel)
+					next = node->right;
+				else
+					next = node->parent();
+			}
+			else if (prev == node->left && node->right != sentinel)
+			{
+				next = node->right;
+			}
+			else
+			{
+				next = node->parent();
+			}
+
+			if (next == node->parent())
+			{
+				leave(node);
+				depth--;
+			}
+			else
+			{
+				depth++;
+			}
+
+			prev = node;
+			node = next;
+		}
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	void RBTree<TKey, TValue, TComp, TAugment>::remove(const TKey& key)
+	{
+		Node *z = findNode(key);
+		if (z != sentinel)
+			removeNode(z);
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	void RBTree<TKey, TValue, TComp, TAugment>::removeNode(Node* z)
+	{
 		Node *y = z;
-		bool yOriginalColor = y->color;
+		bool yOriginalColor = y->color();
 
 		Node *x = nullptr;
 
@@ -331,38 +1168,42 @@ namespace algs {
 		else
 		{
 			y = findMinNode(z->right);
-			yOriginalColor = y->color;
+			yOriginalColor = y->color();
 			x = y->right;
 
-			if (y->parent == z)
+			if (y->parent() == z)
 			{
-				x->parent = y;
+				x->setParent(y);
 			}
 			else
 			{
 				transplant(y, y->right);
 				y->right = z->right;
-				y->right->parent = y;
+				y->right->setParent(y);
 			}
 
 			transplant(z, y);
 			y->left = z->left;
-			y->left->parent = y;
-			y->color = z->color;
+			y->left->setParent(y);
+			y->setColor(z->color());
 		}
 
+		// x->parent() is where the tree lost a node, even when x is the sentinel.
+		refreshPath(x->parent());
+
 		if (yOriginalColor == black)
 		{
 			removeFixup(x);
 		}
 
 		delete z;
-		assert(root->color == black);
+		count--;
+		assert(root->color() == black);
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	typename RBTree<TKey, TValue, TComp>::Node*
-		RBTree<TKey, TValue, TComp>::findMinNode(Node* node) const
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	typename RBTree<TKey, TValue, TComp, TAugment>::Node*
+		RBTree<TKey, TValue, TComp, TAugment>::findMinNode(Node* node) const
 	{
 		Node* ptr = node;
 
@@ -374,9 +1215,9 @@ namespace algs {
 		return ptr;
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	typename RBTree<TKey, TValue, TComp>::Node*
-		RBTree<TKey, TValue, TComp>::findMaxNode(Node* node) const
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	typename RBTree<TKey, TValue, TComp, TAugment>::Node*
+		RBTree<TKey, TValue, TComp, TAugment>::findMaxNode(Node* node) const
 	{
 		Node* ptr = node;
 
@@ -388,70 +1229,101 @@ namespace algs {
 		return ptr;
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	typename RBTree<TKey, TValue, TComp>::Node*
-		RBTree<TKey, TValue, TComp>::findNode(const TKey& key) const
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	template <typename TLookup>
+	typename RBTree<TKey, TValue, TComp, TAugment>::Node*
+		RBTree<TKey, TValue, TComp, TAugment>::findNode(const TLookup& key) const
 	{
 		Node * ptr = root;
 
-		while (ptr != sentinel && ptr->key() != key)
+		while (ptr != sentinel)
 		{
 			if (comp(key, ptr->key()))
 			{
 				ptr = ptr->left;
 			}
-			else
+			else if (comp(ptr->key(), key))
 			{
 				ptr = ptr->right;
 			}
+			else
+			{
+				break;
+			}
+		}
+
+		return ptr;
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	typename RBTree<TKey, TValue, TComp, TAugment>::Node*
+		RBTree<TKey, TValue, TComp, TAugment>::nextNode(Node* node) const
+	{
+		if (node->right != sentinel)
+			return findMinNode(node->right);
+
+		Node* ptr = node->parent();
+
+		while (ptr != sentinel && node == ptr->right)
+		{
+			node = ptr;
+			ptr = ptr->parent();
 		}
 
 		return ptr;
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	void RBTree<TKey, TValue, TComp>::print(Node* node) const
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	void RBTree<TKey, TValue, TComp, TAugment>::print(Node* node) const
 	{
 		if (node == sentinel)
 			return;
 
-		print(node->left);
-		std::cout << node->key() << " (" << node->value() << ") ";
-		print(node->right);
+		for (Node* ptr = findMinNode(node); ptr != sentinel; ptr = nextNode(ptr))
+			std::cout << ptr->key() << " (" << ptr->value() << ") ";
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	void RBTree<TKey, TValue, TComp>::insertFixup(Node* nodePtr)
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	size_t RBTree<TKey, TValue, TComp, TAugment>::insertFixup(Node* nodePtr)
 	{
-		while (nodePtr->parent->color == red) // "" - 
+		// Rotations only happen in the last step, which ends the loop. The rotation at
+		// the grandparent lifts the current node and its subtree by one level; the one
+		// at the parent before it lifts the current node itself by one more.
+		Node* inserted = nodePtr;
+		size_t lift = 0;
+
+		while (nodePtr->parent()->color() == red) // "" - 
 		{
-			if (nodePtr->parent == nodePtr->parent->parent->left)
+			if (nodePtr->parent() == nodePtr->parent()->parent()->left)
 			{
-				Node * tmp = nodePtr->parent->parent->right;
-				if (tmp->color == red) 
+				Node * tmp = nodePtr->parent()->parent()->right;
+				if (tmp->color() == red) 
 				{
 					//  1.
 					// ""  nodePtr 
 
 					//   ""  ""  
-					nodePtr->parent->color = black;
-					tmp->color = black;
+					nodePtr->parent()->setColor(black);
+					tmp->setColor(black);
 
 					//   ""         .
-					nodePtr->parent->parent->color = red;
-					nodePtr = nodePtr->parent->parent;
+					nodePtr->parent()->parent()->setColor(red);
+					nodePtr = nodePtr->parent()->parent();
 				}
 				else 
 				{
 					// ""  nodePtr 
 
-					if (nodePtr == nodePtr->parent->right)
+					if (nodePtr == nodePtr->parent()->right)
 					{
 						//  2.
 						// ""  nodePtr , nodePtr -  
 						//   ,    3.
 
-						nodePtr = nodePtr->parent;
+						if (nodePtr == inserted)
+							lift++;
+
+						nodePtr = nodePtr->parent();
 						rotateLeft(nodePtr);
 					}
 
@@ -460,188 +1332,201 @@ namespace algs {
 
 					// ""  ,  "" .
 					//    RB  .
-					nodePtr->parent->color = black;
-					nodePtr->parent->parent->color = red;
-					rotateRight(nodePtr->parent->parent);
+					nodePtr->parent()->setColor(black);
+					nodePtr->parent()->parent()->setColor(red);
+					rotateRight(nodePtr->parent()->parent());
+					lift++;
 				}
 			}
 			else
 			{
 				//     ,   .
 
-				Node * tmp = nodePtr->parent->parent->left;
-				if (tmp->color == red) // Case 1.
+				Node * tmp = nodePtr->parent()->parent()->left;
+				if (tmp->color() == red) // Case 1.
 				{
-					nodePtr->parent->color = black;
-					tmp->color = black;
-					nodePtr->parent->parent->color = red;
-					nodePtr = nodePtr->parent->parent;
+					nodePtr->parent()->setColor(black);
+					tmp->setColor(black);
+					nodePtr->parent()->parent()->setColor(red);
+					nodePtr = nodePtr->parent()->parent();
 				}
 				else
 				{
-					if (nodePtr == nodePtr->parent->left) // Case 2
+					if (nodePtr == nodePtr->parent()->left) // Case 2
 					{
-						nodePtr = nodePtr->parent;
+						if (nodePtr == inserted)
+							lift++;
+
+						nodePtr = nodePtr->parent();
 						rotateRight(nodePtr);
 					}
 
 					// Case 3
-					nodePtr->parent->color = black;
-					nodePtr->parent->parent->color = red;
-					rotateLeft(nodePtr->parent->parent);
+					nodePtr->parent()->setColor(black);
+					nodePtr->parent()->parent()->setColor(red);
+					rotateLeft(nodePtr->parent()->parent());
+					lift++;
 				}
 			}
 		}
 
-		root->color = black;
+		root->setColor(black);
+
+		return lift;
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	void RBTree<TKey, TValue, TComp>::removeFixup(Node* nodePtr)
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	void RBTree<TKey, TValue, TComp, TAugment>::removeFixup(Node* nodePtr)
 	{
 		assert(nodePtr != nullptr);
 
 		Node *x = nodePtr;
-		while (x != root && x->color == black)
+		while (x != root && x->color() == black)
 		{
-			if (x == x->parent->left)
+			if (x == x->parent()->left)
 			{
-				Node *w = x->parent->right;
-				if (w->color == red)
+				Node *w = x->parent()->right;
+				if (w->color() == red)
 				{
 					// Case 1.
-					w->color = black;
-					x->parent->color = red;
-					rotateLeft(x->parent);
-					w = x->parent->right;
+					w->setColor(black);
+					x->parent()->setColor(red);
+					rotateLeft(x->parent());
+					w = x->parent()->right;
 				}
 
-				if (w->left->color == black && w->right->color == black)
+				if (w->left->color() == black && w->right->color() == black)
 				{
 					// Case 2.
-					w->color = red;
-					x = x->parent;
+					w->setColor(red);
+					x = x->parent();
 				}
 				else
 				{
-					if (w->right->color == black)
+					if (w->right->color() == black)
 					{
 						// Case 3.
-						w->left->color = black;
-						w->color = red;
+						w->left->setColor(black);
+						w->setColor(red);
 						rotateRight(w);
-						w = x->parent->right;
+						w = x->parent()->right;
 					}
 
 					// Case 4.
-					w->color = x->parent->color;
-					x->parent->color = black;
-					w->right->color = black;
-					rotateLeft(x->parent);
+					w->setColor(x->parent()->color());
+					x->parent()->setColor(black);
+					w->right->setColor(black);
+					rotateLeft(x->parent());
 					x = root;
 				}
 			}
 			else
 			{
-				Node *w = x->parent->left;
-				if (w->color == red)
+				Node *w = x->parent()->left;
+				if (w->color() == red)
 				{
 					// Case 1.
-					w->color = black;
-					x->parent->color = red;
-					rotateRight(x->parent);
-					w = x->parent->left;
+					w->setColor(black);
+					x->parent()->setColor(red);
+					rotateRight(x->parent());
+					w = x->parent()->left;
 				}
 
-				if (w->right->color == black && w->left->color == black)
+				if (w->right->color() == black && w->left->color() == black)
 				{
 					// Case 2.
-					w->color = red;
-					x = x->parent;
+					w->setColor(red);
+					x = x->parent();
 				}
 				else
 				{
-					if (w->left->color == black)
+					if (w->left->color() == black)
 					{
 						// Case 3.
-						w->right->color = black;
-						w->color = red;
+						w->right->setColor(black);
+						w->setColor(red);
 						rotateLeft(w);
-						w = x->parent->left;
+						w = x->parent()->left;
 					}
 
 					// Case 4.
-					w->color = x->parent->color;
-					x->parent->color = black;
-					w->left->color = black;
-					rotateRight(x->parent);
+					w->setColor(x->parent()->color());
+					x->parent()->setColor(black);
+					w->left->setColor(black);
+					rotateRight(x->parent());
 					x = root;
 				}
 			}
 		}
 
-		x->color = black;
+		x->setColor(black);
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	void RBTree<TKey, TValue, TComp>::rotateLeft(Node* nodePtr)
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	void RBTree<TKey, TValue, TComp, TAugment>::rotateLeft(Node* nodePtr)
 	{
 		Node * tmp = nodePtr->right;
 		nodePtr->right = tmp->left;
 
 		if (tmp->left != sentinel)
-			tmp->left->parent = nodePtr;
+			tmp->left->setParent(nodePtr);
 
-		tmp->parent = nodePtr->parent;
-		if (nodePtr->parent == sentinel)
+		tmp->setParent(nodePtr->parent());
+		if (nodePtr->parent() == sentinel)
 			root = tmp;
-		else if (nodePtr == nodePtr->parent->left)
-			nodePtr->parent->left = tmp;
+		else if (nodePtr == nodePtr->parent()->left)
+			nodePtr->parent()->left = tmp;
 		else 
-			nodePtr->parent->right = tmp;
+			nodePtr->parent()->right = tmp;
 
 		tmp->left = nodePtr;
-		nodePtr->parent = tmp;
+		nodePtr->setParent(tmp);
+
+		refresh(nodePtr);
+		refresh(tmp);
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	void RBTree<TKey, TValue, TComp>::rotateRight(Node* nodePtr)
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	void RBTree<TKey, TValue, TComp, TAugment>::rotateRight(Node* nodePtr)
 	{
 		Node * tmp = nodePtr->left;
 		nodePtr->left = tmp->right;
 
 		if (tmp->right != sentinel)
-			tmp->right->parent = nodePtr;
+			tmp->right->setParent(nodePtr);
 
-		tmp->parent = nodePtr->parent;
-		if (nodePtr->parent == sentinel)
+		tmp->setParent(nodePtr->parent());
+		if (nodePtr->parent() == sentinel)
 			root = tmp;
-		else if (nodePtr == nodePtr->parent->left)
-			nodePtr->parent->left = tmp;
+		else if (nodePtr == nodePtr->parent()->left)
+			nodePtr->parent()->left = tmp;
 		else
-			nodePtr->parent->right = tmp;
+			nodePtr->parent()->right = tmp;
 
 		tmp->right = nodePtr;
-		nodePtr->parent = tmp;
+		nodePtr->setParent(tmp);
+
+		refresh(nodePtr);
+		refresh(tmp);
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	void RBTree<TKey, TValue, TComp>::transplant(Node* prevNode, Node* newNode)
+	template <typename TKey, typename TValue, typename TComp, typename TAugment>
+	void RBTree<TKey, TValue, TComp, TAugment>::transplant(Node* prevNode, Node* newNode)
 	{
-		if (prevNode->parent == sentinel)
+		if (prevNode->parent() == sentinel)
 		{
 			root = newNode;
 		}
-		else if (prevNode == prevNode->parent->left)
+		else if (prevNode == prevNode->parent()->left)
 		{
-			prevNode->parent->left = newNode;
+			prevNode->parent()->left = newNode;
 		}
 		else
 		{
-			prevNode->parent->right = newNode;
+			prevNode->parent()->right = newNode;
 		}
 
-		newNode->parent = prevNode->parent;
+		newNode->setParent(prevNode->parent());
 	}
 }
 
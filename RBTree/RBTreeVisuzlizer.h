@@ -1,8 +1,11 @@
 #pragma once
 
 #include "RBTree.h"
+#include "TreeExport.h"
 #include <string>
 #include <fstream>
+#include <type_traits>
+#include <vector>
 
 namespace algs
 {
@@ -11,82 +14,121 @@ namespace algs
 	template <
 		typename TKey,
 		typename TValue,
-		typename TComp
+		typename TComp,
+		typename TAugment = NoAugment
 	>
 	class RBTreeVisualizer
 	{
 		static constexpr bool black = false;
 		static constexpr bool red = true;
 
-		using NodePtr = typename RBTree<TKey, TValue, TComp>::Node*;
+		using NodePtr = typename RBTree<TKey, TValue, TComp, TAugment>::Node*;
 
 	public:
-		
 
-		explicit RBTreeVisualizer(const RBTree<TKey, TValue, TComp>& tree)
-			: tree(tree), num_of_sentinels(0)
+
+		explicit RBTreeVisualizer(const RBTree<TKey, TValue, TComp, TAugment>& tree)
+			: tree(tree)
+		{
+		}
+
+		// Streams the tree in a single iterative pass. Nodes deeper than maxDepth
+		// are replaced with a "..." marker.
+		void saveDot(const std::string& fileName, size_t maxDepth = treeExport::unlimitedDepth) const
 		{
+			writeDot(fileName, tree.root, maxDepth);
 		}
 
-		void saveDot(const std::string& fileName) const
+		// Exports only the subtree rooted at the node with the given key.
+		void saveDot(const std::string& fileName, const TKey& subtreeKey, size_t maxDepth) const
 		{
-			num_of_sentinels = 0;
-			ofstream file(fileName);
+			writeDot(fileName, subtreeNode(subtreeKey), maxDepth);
+		}
 
-			file << "digraph RBTree {" << endl;
-			file << "\t" << "graph" << " [ordering=out dpi = 300]" << endl;
+		// Compact preorder dump for offline tools: the treeExport header, then per node
+		// a BinaryFlags byte followed by the raw key bytes.
+		void saveBinary(const std::string& fileName, size_t maxDepth = treeExport::unlimitedDepth) const
+		{
+			writeBinary(fileName, tree.root, maxDepth);
+		}
 
-			printDOT_Pass1(file, tree.root);
-			printDOT_Pass2(file, tree.root);
-			file << "}";
-			file.close();
+		void saveBinary(const std::string& fileName, const TKey& subtreeKey, size_t maxDepth) const
+		{
+			writeBinary(fileName, subtreeNode(subtreeKey), maxDepth);
 		}
 
 	private:
-		void printDOT_Pass1(ofstream &file, NodePtr node) const
+		NodePtr subtreeNode(const TKey& key) const
 		{
+			NodePtr node = tree.findNode(key);
 			if (node == tree.sentinel)
-				return;
-
-			if (node->color == black)
-				file << "\t" << "node" << node->key() << " [style=filled color=black fontcolor=white label=" << node->key() << "]" << endl;
-			else if (node->color == red)
-				file << "\t" << "node" << node->key() << " [style=filled color=red fontcolor=white label=" << node->key() << "]" << endl;
+				throw std::exception("Cannot find node");
 
-			printDOT_Pass1(file, node->left);
-			printDOT_Pass1(file, node->right);
+			return node;
 		}
 
-		void printDOT_Pass2(ofstream &file, NodePtr node) const
+		void writeDot(const std::string& fileName, NodePtr subtreeRoot, size_t maxDepth) const
 		{
-			if (node == tree.sentinel)
-				return;
+			vector<char> buffer;
+			ofstream file;
+			treeExport::open(file, buffer, fileName);
 
-			if (node->left != tree.sentinel)
-			{
-				file << "\t" << "node" << node->key() << " -> " << "node" << node->left->key() << endl;
-			}
-			else
+			file << "digraph RBTree {\n";
+			file << "\tgraph [ordering=out dpi = 300]\n";
+
+			size_t leaves = 0;
+			treeExport::walk(subtreeRoot, tree.sentinel, maxDepth, [](NodePtr node) { return node->parent(); }, [&](NodePtr node, size_t depth)
 			{
-				file << "\t" << "NIL" << num_of_sentinels << " [shape=box style=filled color=black fontcolor=white label=NIL]" << endl; 
-				file << "\t" << "node" << node->key() << " -> NIL" << num_of_sentinels++ << endl;				
-			}
+				file << "\tn" << node << " [style=filled color=" << (node->color() == red ? "red" : "black")
+					<< " fontcolor=white label=\"" << node->key() << "\"]\n";
+
+				printEdge(file, node, node->left, depth < maxDepth, leaves);
+				printEdge(file, node, node->right, depth < maxDepth, leaves);
+			});
+
+			file << "}\n";
+		}
 
-			if (node->right != tree.sentinel)
+		void printEdge(ofstream& file, NodePtr node, NodePtr child, bool expanded, size_t& leaves) const
+		{
+			if (child != tree.sentinel && expanded)
 			{
-				file << "\t" << "node" << node->key() << " -> " << "node" << node->right->key() << endl;
+				file << "\tn" << node << " -> n" << child << "\n";
+				return;
 			}
+
+			if (child == tree.sentinel)
+				file << "\tL" << leaves << " [shape=box style=filled color=black fontcolor=white label=NIL]\n";
 			else
+				file << "\tL" << leaves << " [shape=plaintext label=\"...\"]\n";
+
+			file << "\tn" << node << " -> L" << leaves++ << "\n";
+		}
+
+		void writeBinary(const std::string& fileName, NodePtr subtreeRoot, size_t maxDepth) const
+		{
+			static_assert(std::is_trivially_copyable<TKey>::value, "Binary export needs trivially copyable keys");
+
+			vector<char> buffer;
+			ofstream file;
+			treeExport::open(file, buffer, fileName, ios_base::out | ios_base::binary);
+			treeExport::writeBinaryHeader(file, sizeof(TKey), 0);
+
+			treeExport::walk(subtreeRoot, tree.sentinel, maxDepth, [](NodePtr node) { return node->parent(); }, [&](NodePtr node, size_t depth)
 			{
-				file << "\t" << "NIL" << num_of_sentinels << " [shape=box style=filled color=black fontcolor=white label=NIL]" << endl;
-				file << "\t" << "node" << node->key() << " -> NIL" << num_of_sentinels++ << endl;
-			}
+				uint8_t flags = node->color() == red ? treeExport::isRed : 0;
 
-			printDOT_Pass2(file, node->left);
-			printDOT_Pass2(file, node->right);
+				if (node->left != tree.sentinel)
+					flags |= depth < maxDepth ? treeExport::hasLeft : treeExport::leftTruncated;
+				if (node->right != tree.sentinel)
+					flags |= depth < maxDepth ? treeExport::hasRight : treeExport::rightTruncated;
+
+				file.put(static_cast<char>(flags));
+				file.write(reinterpret_cast<const char*>(&node->key()), sizeof(TKey));
+			});
 		}
+
 	private:
-		const RBTree<TKey, TValue, TComp>& tree;
-		mutable int num_of_sentinels;
+		const RBTree<TKey, TValue, TComp, TAugment>& tree;
 	};
 }
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+
+namespace algs {
+
+	// Small, fast generators for randomized data structures. Each one keeps its
+	// whole state inside the object, so every tree owns an independent stream and
+	// trees in different threads never share state. All of them yield 32-bit
+	// values from operator() and are seeded explicitly; a default-constructed
+	// generator always starts from the same fixed seed.
+
+	// Marsaglia's xorshift64 with Vigna's multiplicative scrambler.
+	class XorShift64Star
+	{
+	public:
+		explicit XorShift64Star(uint64_t seed = 0x9E3779B97F4A7C15ull) :
+			state(seed != 0 ? seed : 0x9E3779B97F4A7C15ull)
+		{
+		}
+
+		uint32_t operator()()
+		{
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return static_cast<uint32_t>((state * 0x2545F4914F6CDD1Dull) >> 32);
+		}
+
+	private:
+		uint64_t state;
+	};
+
+	// O'Neill's PCG32 (XSH RR output on a 64-bit LCG).
+	class Pcg32
+	{
+	public:
+		explicit Pcg32(uint64_t seed = 0x853C49E6748FEA9Bull, uint64_t stream = 0xDA3E39CB94B95BDBull) :
+			state(0),
+			increment((stream << 1) | 1)
+		{
+			(*this)();
+			state += seed;
+			(*this)();
+		}
+
+		uint32_t operator()()
+		{
+			uint64_t old = state;
+			state = old * 6364136223846793005ull + increment;
+
+			uint32_t shifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+			uint32_t rotation = static_cast<uint32_t>(old >> 59);
+			return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+		}
+
+	private:
+		uint64_t state;
+		uint64_t increment;
+	};
+
+	// Wang Yi's wyrand: a Weyl sequence mixed by one wide multiplication.
+	class WyRand
+	{
+	public:
+		explicit WyRand(uint64_t seed = 0) :
+			state(seed)
+		{
+		}
+
+		uint32_t operator()()
+		{
+			state += 0xA0761D6478BD642Full;
+
+			uint64_t high;
+			uint64_t low = multiply(state, state ^ 0xE7037ED1A0B428DBull, high);
+			return static_cast<uint32_t>(low ^ high);
+		}
+
+	private:
+		// Full 64 x 64 -> 128 bit product from 32-bit halves, portable to every target.
+		static uint64_t multiply(uint64_t a, uint64_t b, uint64_t& high)
+		{
+			uint64_t aLow = a & 0xFFFFFFFF, aHigh = a >> 32;
+			uint64_t bLow = b & 0xFFFFFFFF, bHigh = b >> 32;
+
+			uint64_t lowLow = aLow * bLow;
+			uint64_t lowHigh = aLow * bHigh;
+			uint64_t highLow = aHigh * bLow;
+			uint64_t highHigh = aHigh * bHigh;
+
+			uint64_t middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFF) + (highLow & 0xFFFFFFFF);
+			high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+			return (middle << 32) | (lowLow & 0xFFFFFFFF);
+		}
+
+	private:
+		uint64_t state;
+	};
+
+	// Uniform value in [0, range) for range > 0, without the modulo bias of
+	// random() % range and, in almost all calls, without a division
+	// (Lemire, "Fast Random Integer Generation in an Interval").
+	template <typename TRandom>
+	uint32_t uniform(TRandom& random, uint32_t range)
+	{
+		uint64_t product = static_cast<uint64_t>(random()) * range;
+		uint32_t low = static_cast<uint32_t>(product);
+
+		if (low < range)
+		{
+			uint32_t threshold = (0u - range) % range;
+
+			while (low < threshold)
+			{
+				product = static_cast<uint64_t>(random()) * range;
+				low = static_cast<uint32_t>(product);
+			}
+		}
+
+		return static_cast<uint32_t>(product >> 32);
+	}
+}
@@ -11,7 +11,10 @@
 #include <iostream>
 #include <utility>
 #include <algorithm>
-#include <queue>
+#include <vector>
+#include "TreeStats.h"
+#include "TreeSnapshot.h"
+#include "Random.h"
 
 
 namespace algs {
@@ -19,22 +22,27 @@ namespace algs {
 	template <
 		typename TKey1,
 		typename TValue1,
-		typename TComp1
+		typename TComp1,
+		typename TRandom1
 	>
 	class RandomizedBSTVisualizer;
 
 	// https://habrahabr.ru/post/145388/
+	// TRandom is any generator from Random.h, or one with the same interface.
+	// Each tree owns its generator, so trees in different threads do not contend.
 	template <
 		typename TKey,
 		typename TValue,
-		typename TComp = std::less<TKey>
+		typename TComp = std::less<TKey>,
+		typename TRandom = WyRand
 	>
 	class RandomizedBST
 	{
 		template <
 			typename TKey1,
 			typename TValue1,
-			typename TComp1
+			typename TComp1,
+			typename TRandom1
 		>
 		friend class RandomizedBSTVisualizer;
 
@@ -56,20 +64,35 @@ namespace algs {
 				size(1)
 			{ }
 
-			TKey key() const { return keyValue.first; }
+			const TKey& key() const { return keyValue.first; }
 
-			TValue value() const { return keyValue.second; }
+			TValue& value() { return keyValue.second; }
+
+			const TValue& value() const { return keyValue.second; }
 		};
 
 	public:
 		explicit RandomizedBST() :
 			root(nullptr),
-			comp()
+			comp(),
+			lastInsertDepth(0),
+			maxInsertDepth(0)
 		{}
 
 		explicit RandomizedBST(const TComp& comp) :
 			root(nullptr),
-			comp(comp)
+			comp(comp),
+			lastInsertDepth(0),
+			maxInsertDepth(0)
+		{}
+
+		// The same seed and the same sequence of operations always give the same tree.
+		explicit RandomizedBST(const TComp& comp, const TRandom& random) :
+			root(nullptr),
+			comp(comp),
+			random(random),
+			lastInsertDepth(0),
+			maxInsertDepth(0)
 		{}
 
 		~RandomizedBST()
@@ -79,56 +102,122 @@ namespace algs {
 
 		void insert(const TKey& key, const TValue& value);
 
-		const TValue& find(const TKey& key);
+		const TValue& find(const TKey& key) const;
+
+		// Lookup by any type the comparator can compare with TKey (see RBTree::find).
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		const TValue& find(const TLookup& key) const
+		{
+			Node* ptr = findNode(key);
+
+			if (ptr == nullptr)
+				throw std::exception("Cannot find node");
+
+			return ptr->value();
+		}
 
-		std::pair<TKey&, TValue&> min();
+		bool contains(const TKey& key) const
+		{
+			return findNode(key) != nullptr;
+		}
 
-		std::pair<TKey&, TValue&> max();
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		bool contains(const TLookup& key) const
+		{
+			return findNode(key) != nullptr;
+		}
+
+		std::pair<const TKey&, TValue&> min() const;
+
+		std::pair<const TKey&, TValue&> max() const;
 
 		void print() const
 		{
 			print(root);
 		}
 
-		TKey& successor(const TKey& key)
+		size_t size() const
 		{
-			Node * keyNode = findNode(key);
+			return getSize(root);
+		}
 
-			if (keyNode == nullptr)
-				return nullptr;
+		// Calls visit(key, value) for every entry in key order.
+		template <typename TFunc>
+		void forEach(TFunc visit) const
+		{
+			if (root == nullptr)
+				return;
+
+			for (Node * ptr = findMinNode(root); ptr != nullptr; ptr = nextNode(ptr))
+				visit(ptr->key(), ptr->value());
+		}
 
-			if (keyNode->right != nullptr)
+		// Calls visit(key, value) for every entry with from <= key < to, in order.
+		// Returns the number of entries visited.
+		template <typename TFunc>
+		size_t range(const TKey& from, const TKey& to, TFunc visit) const
+		{
+			// Lowest node not below from.
+			Node* first = nullptr;
+
+			for (Node* node = root; node != nullptr; )
 			{
-				Node * ptr = findMinNode(keyNode->right);
-				return ptr->key();
+				if (comp(node->key(), from))
+				{
+					node = node->right;
+				}
+				else
+				{
+					first = node;
+					node = node->left;
+				}
 			}
 
-			Node * ptr = keyNode->parent;
+			size_t visited = 0;
 
-			while (ptr != nullptr && keyNode == ptr->right)
+			for (Node* ptr = first; ptr != nullptr && comp(ptr->key(), to); ptr = nextNode(ptr))
 			{
-				keyNode = ptr;
-				ptr = ptr->parent;
+				visit(ptr->key(), ptr->value());
+				visited++;
 			}
 
+			return visited;
+		}
+
+		const TKey& successor(const TKey& key) const
+		{
+			Node * keyNode = findNode(key);
+
+			if (keyNode == nullptr)
+				throw std::exception("Cannot find node");
+
+			Node * ptr = nextNode(keyNode);
+
 			if (ptr == nullptr)
-				throw std::exception();
+				throw std::exception("Cannot find successor");
 
 			return ptr->key();
-
 		}
 
-		TKey& predecessor(const TKey& key)
+		const TKey& predecessor(const TKey& key) const
 		{
 			Node * keyNode = findNode(key);
 
 			if (keyNode == nullptr)
-				return nullptr;
+				throw std::exception("Cannot find node");
 
 			if (keyNode->left != nullptr)
 			{
 				Node *ptr = findMaxNode(keyNode->left);
-				return ptr->key;
+				return ptr->key();
 			}
 
 			Node * ptr = keyNode->parent;
@@ -140,62 +229,84 @@ namespace algs {
 			}
 
 			if (ptr == nullptr)
-				throw std::exception();
+				throw std::exception("Cannot find predecessor");
 
-			return ptr->key;
+			return ptr->key();
 		}
 
-		void remove(const TKey& key)
-		{
-			root = removeImpl(root, key);
-		}
+		void remove(const TKey& key);
 
 		size_t height() const
 		{
-			if (root == nullptr)
-				return 0;
-
-			std::queue<Node *> queue;
-
 			size_t h = 0;
-			queue.push(root);
+			walk([&h](const Node*, size_t depth) { h = std::max(h, depth); });
+			return h;
+		}
+
+		TreeCounters counters() const
+		{
+			TreeCounters result = TreeCounters();
+			result.nodeCount = getSize(root);
+			result.lastInsertDepth = lastInsertDepth;
+			result.maxInsertDepth = maxInsertDepth;
+			result.bytesPerNode = sizeof(Node);
 
-			while (true)
+			if (root != nullptr && root->size > 1)
 			{
-				int nodeCount = queue.size();
+				int larger = std::max(getSize(root->left), getSize(root->right));
+				result.rootImbalance = static_cast<double>(larger) / (root->size - 1);
+			}
 
-				if (nodeCount == 0)
-					return h;
-				else
-					h++;
+			return result;
+		}
 
-				while (nodeCount > 0)
-				{
-					Node * node = queue.back();
-					queue.pop();
+		// O(n), see statsAsync() to run it off the calling thread.
+		TreeStats stats() const;
 
-					if (node->left != nullptr)
-						queue.push(node->left);
+		// Writes the entries to a binary snapshot, see TreeSnapshot.h.
+		void save(const std::string& fileName) const
+		{
+			snapshot::write<TKey, TValue>(fileName, *this);
+		}
 
-					if (node->right != nullptr)
-						queue.push(node->right);
+		// Replaces the contents with a snapshot, rebuilt bottom-up in O(n)
+		// with subtree sizes filled in on the way. Built in a separate tree and
+		// swapped in, so an exception leaves the contents as they were.
+		void load(const std::string& fileName)
+		{
+			std::vector<TKey> keys;
+			std::vector<TValue> values;
+			snapshot::read(fileName, keys, values);
 
-					nodeCount--;
-				}
-			}
-		}
+			RandomizedBST loaded(comp, random);
+			loaded.build(keys.data(), values.data(), keys.size());
 
+			std::swap(root, loaded.root);
+			lastInsertDepth = 0;
+			maxInsertDepth = 0;
+		}
 
 	private:
 		void clean(Node* node)
 		{
-			if (node == nullptr)
-				return;
-
-			clean(node->left);
-			clean(node->right);
-
-			delete node;
+			// Rotate left children up until the tree is a right-leaning list,
+			// deleting nodes as they reach the head of the list.
+			while (node != nullptr)
+			{
+				if (node->left != nullptr)
+				{
+					Node * child = node->left;
+					node->left = child->right;
+					child->right = node;
+					node = child;
+				}
+				else
+				{
+					Node * next = node->right;
+					delete node;
+					node = next;
+				}
+			}
 		}
 
 		void print(Node * node) const
@@ -203,16 +314,23 @@ namespace algs {
 			if (node == nullptr)
 				return;
 
-			print(node->left);
-			std::cout << node->key << "(" << node->value << ") ";
-			print(node->right);
+			for (Node * ptr = findMinNode(node); ptr != nullptr; ptr = nextNode(ptr))
+				std::cout << ptr->key() << "(" << ptr->value() << ") ";
 		}
 
-		Node* findNode(const TKey& key);
+		template <typename TLookup>
+		Node* findNode(const TLookup& key) const;
 
-		Node* findMinNode(Node* node);
+		Node* findMinNode(Node* node) const;
 
-		Node* findMaxNode(Node* node);
+		Node* findMaxNode(Node* node) const;
+
+		Node* nextNode(Node* node) const;
+
+		// Depth-first walk over parent pointers: no recursion and no auxiliary storage.
+		// Calls visit(node, depth) for every node in preorder, the root at depth 1.
+		template <typename TFunc>
+		void walk(TFunc visit) const;
 
 		static int getSize(Node *node)
 		{
@@ -229,148 +347,262 @@ namespace algs {
 
 		Node * rotateLeft(Node *nodePtr);
 
-		Node * insertRoot(Node *node, const TKey& key, const TValue& value)
+		Node *join(Node *left, Node *right);
+
+		void build(const TKey* keys, const TValue* values, size_t n);
+
+
+	private:
+		Node * root;
+		TComp comp;
+		TRandom random;
+		size_t lastInsertDepth;
+		size_t maxInsertDepth;
+	};
+
+
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	void RandomizedBST<TKey, TValue, TComp, TRandom>::insert(const TKey& key, const TValue& value)
+	{
+		Node * newNode = new Node(key, value);
+
+		// Descend while the new node does not win the draw for the root of the current subtree.
+		Node * top = root;
+		Node * topParent = nullptr;
+		size_t depth = 1;
+
+		while (top != nullptr && uniform(random, top->size + 1) != 0)
 		{
-			if (node == nullptr)
-				return new Node(key, value);
+			top->size++;
+			depth++;
+			topParent = top;
+			top = comp(key, top->key()) ? top->left : top->right;
+		}
 
-			if (comp(key, node->key()))
-			{
-				Node* newNode = insertRoot(node->left, key, value);
-				newNode->parent = node;
-				node->left = newNode;
-				return rotateRight(node);
-			}
+		// Hang the new node as a leaf below top...
+		Node * parent = topParent;
+		Node * current = top;
+
+		while (current != nullptr)
+		{
+			current->size++;
+			parent = current;
+			current = comp(key, current->key()) ? current->left : current->right;
+		}
+
+		newNode->parent = parent;
+		if (parent == nullptr)
+			root = newNode;
+		else if (comp(key, parent->key()))
+			parent->left = newNode;
+		else
+			parent->right = newNode;
+
+		// ...and rotate it up until it takes top's place.
+		while (newNode->parent != topParent)
+		{
+			if (newNode == newNode->parent->left)
+				rotateRight(newNode->parent);
 			else
-			{
-				Node* newNode = insertRoot(node->right, key, value);
-				newNode->parent = node;
-				node->right = newNode;
-				return rotateLeft(node);
-			}
+				rotateLeft(newNode->parent);
 		}
 
-		Node * insertImpl(Node * node, const TKey& key, const TValue& value)
+		lastInsertDepth = depth;
+		maxInsertDepth = std::max(maxInsertDepth, depth);
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	void RandomizedBST<TKey, TValue, TComp, TRandom>::build(const TKey* keys, const TValue* values, size_t n)
+	{
+		// A perfectly balanced shape, built by splitting every range at its middle.
+		struct Range
 		{
-			if (node == nullptr)
-				return new Node(key, value);
+			size_t from;
+			size_t to;
+			Node * parent;
+			Node ** link;
+		};
 
-			if (rand() % (node->size + 1) == 0)
-				return insertRoot(node, key, value);
+		Range stack[130];
+		size_t top = 0;
+		stack[top++] = Range{ 0, n, nullptr, &root };
 
-			if (comp(key, node->key()))
-			{
-				Node *newNode = insertImpl(node->left, key, value);
-				newNode->parent = node;
-				node->left = newNode;
-			}
-			else
+		while (top > 0)
+		{
+			Range range = stack[--top];
+
+			if (range.from == range.to)
 			{
-				Node *newNode = insertImpl(node->right, key, value);
-				newNode->parent = node;
-				node->right = newNode;
+				*range.link = nullptr;
+				continue;
 			}
 
-			fixSize(node);
-			return node;
+			size_t middle = range.from + (range.to - range.from) / 2;
+
+			Node * node = new Node(keys[middle], values[middle]);
+			node->parent = range.parent;
+			node->size = static_cast<unsigned int>(range.to - range.from);
+			*range.link = node;
+
+			stack[top++] = Range{ middle + 1, range.to, node, &node->right };
+			stack[top++] = Range{ range.from, middle, node, &node->left };
 		}
+	}
 
-		Node *join(Node *left, Node *right);
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	TreeStats RandomizedBST<TKey, TValue, TComp, TRandom>::stats() const
+	{
+		TreeStats result = TreeStats();
+		result.nodeCount = getSize(root);
+		result.bytesPerNode = sizeof(Node);
+
+		if (root == nullptr)
+			return result;
+
+		size_t depthSum = 0;
+		size_t largerSum = 0;
+		size_t childSum = 0;
+		walk([&result, &depthSum, &largerSum, &childSum](const Node* node, size_t depth)
+		{
+			if (result.depthHistogram.size() < depth)
+				result.depthHistogram.resize(depth);
+
+			result.depthHistogram[depth - 1]++;
+			depthSum += depth;
+			largerSum += std::max(getSize(node->left), getSize(node->right));
+			childSum += node->size - 1;
+		});
+
+		result.height = result.depthHistogram.size();
+		result.averageDepth = static_cast<double>(depthSum) / result.nodeCount;
+		if (childSum > 0)
+			result.sizeImbalance = static_cast<double>(largerSum) / childSum;
+
+		return result;
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	template <typename TFunc>
+	void RandomizedBST<TKey, TValue, TComp, TRandom>::walk(TFunc visit) const
+	{
+		size_t depth = 1;
+		Node * prev = nullptr;
+		Node * node = root;
 
-		Node *removeImpl(Node *node, const TKey& key)
+		while (node != nullptr)
 		{
-			if (!node)
-				return node;
+			Node * next;
 
-			if (node->key() == key)
+			if (prev == node->parent)
 			{
-				Node *joinedNode = join(node->left, node->right);
-				delete node;
-				return joinedNode;
+				visit(node, depth);
+
+				if (node->left != nullptr)
+					next = node->left;
+				else if (node->right != nullptr)
+					next = node->right;
+				else
+					next = node->parent;
 			}
-			else if (comp(key, node->key()))
+			else if (prev == node->left && node->right != nullptr)
 			{
-				node->left = removeImpl(node->left, key);
+				next = node->right;
 			}
 			else
 			{
-				node->right = removeImpl(node->right, key);
+				next = node->parent;
 			}
-			return node;
-		}
 
-		size_t height(Node * nodePtr) const
-		{
-			if (nodePtr == nullptr)
-				return 0;
-			return 1 + std::max(height(nodePtr->left), height(nodePtr->right));
+			if (next == node->parent)
+				depth--;
+			else
+				depth++;
+
+			prev = node;
+			node = next;
 		}
+	}
 
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	void RandomizedBST<TKey, TValue, TComp, TRandom>::remove(const TKey& key)
+	{
+		Node * node = findNode(key);
 
-	private:
-		Node * root;
-		TComp comp;
-	};
+		if (node == nullptr)
+			return;
 
+		for (Node * ptr = node->parent; ptr != nullptr; ptr = ptr->parent)
+			ptr->size--;
 
-	template <typename TKey, typename TValue, typename TComp>
-	void RandomizedBST<TKey, TValue, TComp>::insert(const TKey& key, const TValue& value)
-	{
-		Node * node = insertImpl(root, key, value);
-		root = node;
+		Node * joinedNode = join(node->left, node->right);
+
+		if (joinedNode != nullptr)
+			joinedNode->parent = node->parent;
+
+		if (node->parent == nullptr)
+			root = joinedNode;
+		else if (node == node->parent->left)
+			node->parent->left = joinedNode;
+		else
+			node->parent->right = joinedNode;
+
+		delete node;
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	const TValue& RandomizedBST<TKey, TValue, TComp>::find(const TKey& key)
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	const TValue& RandomizedBST<TKey, TValue, TComp, TRandom>::find(const TKey& key) const
 	{
 		Node* ptr = findNode(key);
 
 		if (ptr == nullptr)
-			return nullptr;
+			throw std::exception("Cannot find node");
 
-		return ptr->value;
+		return ptr->value();
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	std::pair<TKey&, TValue&> RandomizedBST<TKey, TValue, TComp>::min()
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	std::pair<const TKey&, TValue&> RandomizedBST<TKey, TValue, TComp, TRandom>::min() const
 	{
-		Node* ptr = findMinNode(this->root);
-		if (ptr == nullptr)
+		if (root == nullptr)
 			throw std::exception("Cannot find node");
 
-		return std::make_pair(ptr->key(), ptr->value());
+		Node* ptr = findMinNode(this->root);
+		return std::pair<const TKey&, TValue&>(ptr->key(), ptr->value());
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	std::pair<TKey&, TValue&> RandomizedBST<TKey, TValue, TComp>::max()
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	std::pair<const TKey&, TValue&> RandomizedBST<TKey, TValue, TComp, TRandom>::max() const
 	{
-		Node* ptr = findMaxNode(this->root);
-		if (ptr == nullptr)
+		if (root == nullptr)
 			throw std::exception("Cannot find node");
 
-		return std::make_pair(ptr->key(), ptr->value());
+		Node* ptr = findMaxNode(this->root);
+		return std::pair<const TKey&, TValue&>(ptr->key(), ptr->value());
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	typename RandomizedBST<TKey, TValue, TComp>::Node*
-		RandomizedBST<TKey, TValue, TComp>::findNode(const TKey& key)
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	template <typename TLookup>
+	typename RandomizedBST<TKey, TValue, TComp, TRandom>::Node*
+		RandomizedBST<TKey, TValue, TComp, TRandom>::findNode(const TLookup& key) const
 	{
 		Node* ptr = root;
 
-		while (ptr != nullptr && ptr->key() != key)
+		while (ptr != nullptr)
 		{
-			if (key < ptr->key())
+			if (comp(key, ptr->key()))
 				ptr = ptr->left;
-			else
+			else if (comp(ptr->key(), key))
 				ptr = ptr->right;
+			else
+				break;
 		}
 
 		return ptr;
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	typename RandomizedBST<TKey, TValue, TComp>::Node*
-		RandomizedBST<TKey, TValue, TComp>::findMinNode(Node* node)
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	typename RandomizedBST<TKey, TValue, TComp, TRandom>::Node*
+		RandomizedBST<TKey, TValue, TComp, TRandom>::findMinNode(Node* node) const
 	{
 		Node* ptr = node;
 
@@ -380,8 +612,8 @@ namespace algs {
 		return ptr;
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	typename RandomizedBST<TKey, TValue, TComp>::Node* RandomizedBST<TKey, TValue, TComp>::findMaxNode(Node* node)
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	typename RandomizedBST<TKey, TValue, TComp, TRandom>::Node* RandomizedBST<TKey, TValue, TComp, TRandom>::findMaxNode(Node* node) const
 	{
 		Node *ptr = node;
 
@@ -391,8 +623,25 @@ namespace algs {
 		return ptr;
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	typename RandomizedBST<TKey, TValue, TComp>::Node* RandomizedBST<TKey, TValue, TComp>::rotateRight(Node* nodePtr)
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	typename RandomizedBST<TKey, TValue, TComp, TRandom>::Node* RandomizedBST<TKey, TValue, TComp, TRandom>::nextNode(Node* node) const
+	{
+		if (node->right != nullptr)
+			return findMinNode(node->right);
+
+		Node * ptr = node->parent;
+
+		while (ptr != nullptr && node == ptr->right)
+		{
+			node = ptr;
+			ptr = ptr->parent;
+		}
+
+		return ptr;
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	typename RandomizedBST<TKey, TValue, TComp, TRandom>::Node* RandomizedBST<TKey, TValue, TComp, TRandom>::rotateRight(Node* nodePtr)
 	{
 		Node * tmp = nodePtr->left;
 		nodePtr->left = tmp->right;
@@ -411,12 +660,13 @@ namespace algs {
 		tmp->right = nodePtr;
 		nodePtr->parent = tmp;
 
+		tmp->size = nodePtr->size;
 		fixSize(nodePtr);
 		return tmp;
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	typename RandomizedBST<TKey, TValue, TComp>::Node* RandomizedBST<TKey, TValue, TComp>::rotateLeft(Node* nodePtr)
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	typename RandomizedBST<TKey, TValue, TComp, TRandom>::Node* RandomizedBST<TKey, TValue, TComp, TRandom>::rotateLeft(Node* nodePtr)
 	{
 		Node * tmp = nodePtr->right;
 		nodePtr->right = tmp->left;
@@ -435,40 +685,49 @@ namespace algs {
 		tmp->left = nodePtr;
 		nodePtr->parent = tmp;
 
+		tmp->size = nodePtr->size;
 		fixSize(nodePtr);
 		return tmp;
 	}
 
-	template <typename TKey, typename TValue, typename TComp>
-	typename RandomizedBST<TKey, TValue, TComp>::Node* RandomizedBST<TKey, TValue, TComp>::join(Node* left, Node* right)
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	typename RandomizedBST<TKey, TValue, TComp, TRandom>::Node* RandomizedBST<TKey, TValue, TComp, TRandom>::join(Node* left, Node* right)
 	{
-		if (left == nullptr)
-			return right;
-
-		if (right == nullptr)
-			return left;
+		// Top-down merge: at each step the root of the joined subtree is drawn
+		// from the two candidates with probability proportional to their sizes.
+		Node *joinedRoot = nullptr;
+		Node **link = &joinedRoot;
+		Node *parent = nullptr;
 
-		if (rand() % (left->size + right->size) < left->size)
+		while (left != nullptr && right != nullptr)
 		{
-			Node *joinedNode = join(left->right, right);
-			if (joinedNode != nullptr)
+			if (uniform(random, left->size + right->size) < left->size)
 			{
-				joinedNode->parent = left;
+				left->size += right->size;
+				left->parent = parent;
+				*link = left;
+
+				parent = left;
+				link = &left->right;
+				left = left->right;
 			}
-			left->right = joinedNode;
-			fixSize(left);
-			return left;
-		}
-		else
-		{
-			Node *joinedNode = join(left, right->left);
-			if (joinedNode != nullptr)
+			else
 			{
-				joinedNode->parent = right;
+				right->size += left->size;
+				right->parent = parent;
+				*link = right;
+
+				parent = right;
+				link = &right->left;
+				right = right->left;
 			}
-			right->left = joinedNode;
-			fixSize(right);
-			return right;
 		}
+
+		Node *rest = left != nullptr ? left : right;
+		if (rest != nullptr)
+			rest->parent = parent;
+		*link = rest;
+
+		return joinedRoot;
 	}
 }
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "RandomizedBST.h"
+#include "TreeExport.h"
 #include <string>
 #include <fstream>
+#include <type_traits>
+#include <vector>
 
 namespace algs
 {
@@ -11,75 +14,117 @@ namespace algs
 	template <
 		typename TKey,
 		typename TValue,
-		typename TComp
+		typename TComp,
+		typename TRandom = WyRand
 	>
 	class RandomizedBSTVisualizer
 	{
-		using NodePtr = typename RandomizedBST<TKey, TValue, TComp>::Node*;
+		using NodePtr = typename RandomizedBST<TKey, TValue, TComp, TRandom>::Node*;
 
 	public:
-		
-		explicit RandomizedBSTVisualizer(const RandomizedBST<TKey, TValue, TComp>& tree)
-			: tree(tree), num_of_sentinels(0)
+
+		explicit RandomizedBSTVisualizer(const RandomizedBST<TKey, TValue, TComp, TRandom>& tree)
+			: tree(tree)
+		{
+		}
+
+		// Streams the tree in a single iterative pass. Nodes deeper than maxDepth
+		// are replaced with a "..." marker.
+		void saveDot(const string& fileName, size_t maxDepth = treeExport::unlimitedDepth) const
 		{
+			writeDot(fileName, tree.root, maxDepth);
 		}
 
-		void saveDot(const string& fileName) const
+		// Exports only the subtree rooted at the node with the given key.
+		void saveDot(const string& fileName, const TKey& subtreeKey, size_t maxDepth) const
 		{
-			num_of_sentinels = 0;
-			ofstream file(fileName);
+			writeDot(fileName, subtreeNode(subtreeKey), maxDepth);
+		}
 
-			file << "digraph RBTree {" << endl;
-			file << "\t" << "graph" << " [ordering=out dpi = 300]" << endl;
+		// Compact preorder dump for offline tools: the treeExport header, then per node
+		// a BinaryFlags byte, the raw key bytes and the subtree size.
+		void saveBinary(const string& fileName, size_t maxDepth = treeExport::unlimitedDepth) const
+		{
+			writeBinary(fileName, tree.root, maxDepth);
+		}
 
-			printDOT_Pass1(file, tree.root);
-			printDOT_Pass2(file, tree.root);
-			file << "}";
-			file.close();
+		void saveBinary(const string& fileName, const TKey& subtreeKey, size_t maxDepth) const
+		{
+			writeBinary(fileName, subtreeNode(subtreeKey), maxDepth);
 		}
 
 	private:
-		void printDOT_Pass1(ofstream &file, NodePtr node) const
+		NodePtr subtreeNode(const TKey& key) const
 		{
+			NodePtr node = tree.findNode(key);
 			if (node == nullptr)
-				return;
+				throw std::exception("Cannot find node");
 
-			file << "\t" << "node" << node->key() << " [label=" << node->key() << "]" << endl;
-			
-			printDOT_Pass1(file, node->left);
-			printDOT_Pass1(file, node->right);
+			return node;
 		}
 
-		void printDOT_Pass2(ofstream &file, NodePtr node) const
+		void writeDot(const string& fileName, NodePtr subtreeRoot, size_t maxDepth) const
 		{
-			if (node == nullptr)
-				return;
+			vector<char> buffer;
+			ofstream file;
+			treeExport::open(file, buffer, fileName);
 
-			if (node->left != nullptr)
-			{
-				file << "\t" << "node" << node->key() << " -> " << "node" << node->left->key() << endl;
-			}
-			else
+			file << "digraph RBTree {\n";
+			file << "\tgraph [ordering=out dpi = 300]\n";
+
+			size_t leaves = 0;
+			treeExport::walk(subtreeRoot, NodePtr(nullptr), maxDepth, [](NodePtr node) { return node->parent; }, [&](NodePtr node, size_t depth)
 			{
-				file << "\t" << "NIL" << num_of_sentinels << " [shape=box label=NIL]" << endl;
-				file << "\t" << "node" << node->key() << " -> NIL" << num_of_sentinels++ << endl;
-			}
+				file << "\tn" << node << " [label=\"" << node->key() << "\"]\n";
 
-			if (node->right !=nullptr)
+				printEdge(file, node, node->left, depth < maxDepth, leaves);
+				printEdge(file, node, node->right, depth < maxDepth, leaves);
+			});
+
+			file << "}\n";
+		}
+
+		void printEdge(ofstream& file, NodePtr node, NodePtr child, bool expanded, size_t& leaves) const
+		{
+			if (child != nullptr && expanded)
 			{
-				file << "\t" << "node" << node->key() << " -> " << "node" << node->right->key() << endl;
+				file << "\tn" << node << " -> n" << child << "\n";
+				return;
 			}
+
+			if (child == nullptr)
+				file << "\tL" << leaves << " [shape=box label=NIL]\n";
 			else
+				file << "\tL" << leaves << " [shape=plaintext label=\"... (" << child->size << ")\"]\n";
+
+			file << "\tn" << node << " -> L" << leaves++ << "\n";
+		}
+
+		void writeBinary(const string& fileName, NodePtr subtreeRoot, size_t maxDepth) const
+		{
+			static_assert(std::is_trivially_copyable<TKey>::value, "Binary export needs trivially copyable keys");
+
+			vector<char> buffer;
+			ofstream file;
+			treeExport::open(file, buffer, fileName, ios_base::out | ios_base::binary);
+			treeExport::writeBinaryHeader(file, sizeof(TKey), sizeof(unsigned int));
+
+			treeExport::walk(subtreeRoot, NodePtr(nullptr), maxDepth, [](NodePtr node) { return node->parent; }, [&](NodePtr node, size_t depth)
 			{
-				file << "\t" << "NIL" << num_of_sentinels << " [shape=box label=NIL]" << endl;
-				file << "\t" << "node" << node->key() << " -> NIL" << num_of_sentinels++ << endl;
-			}
+				uint8_t flags = 0;
+
+				if (node->left != nullptr)
+					flags |= depth < maxDepth ? treeExport::hasLeft : treeExport::leftTruncated;
+				if (node->right != nullptr)
+					flags |= depth < maxDepth ? treeExport::hasRight : treeExport::rightTruncated;
 
-			printDOT_Pass2(file, node->left);
-			printDOT_Pass2(file, node->right);
+				file.put(static_cast<char>(flags));
+				file.write(reinterpret_cast<const char*>(&node->key()), sizeof(TKey));
+				file.write(reinterpret_cast<const char*>(&node->size), sizeof(node->size));
+			});
 		}
+
 	private:
-		const RandomizedBST<TKey, TValue, TComp>& tree;
-		mutable int num_of_sentinels;
+		const RandomizedBST<TKey, TValue, TComp, TRandom>& tree;
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include "TreeSnapshot.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef min
+#undef min
+#endif
+
+#ifdef max
+#undef max
+#endif
+
+namespace algs {
+
+	// Read-only map served straight from a memory-mapped snapshot file:
+	// opening it costs one mmap, pages are loaded on first touch and lookups
+	// binary-search the key array in place. Kept apart from TreeSnapshot.h so only
+	// code using it pulls in the OS mapping headers.
+	template <
+		typename TKey,
+		typename TValue,
+		typename TComp = std::less<TKey>
+	>
+	class SnapshotView
+	{
+	public:
+		explicit SnapshotView(const std::string& fileName, const TComp& comp = TComp()) :
+			comp(comp),
+			data(nullptr),
+			length(0)
+		{
+			static_assert(alignof(TKey) <= snapshot::alignment && alignof(TValue) <= snapshot::alignment, "Snapshots align keys and values to 16 bytes at most");
+
+			map(fileName);
+
+			const snapshot::Header* header = reinterpret_cast<const snapshot::Header*>(data);
+			if (length < sizeof(snapshot::Header) || !snapshot::valid(*header, length, sizeof(TKey), sizeof(TValue)))
+			{
+				unmap();
+				throw std::exception("Invalid snapshot");
+			}
+
+			count = static_cast<size_t>(header->count);
+
+			keys = reinterpret_cast<const TKey*>(data + snapshot::keysOffset());
+			values = reinterpret_cast<const TValue*>(data + snapshot::valuesOffset(count, sizeof(TKey)));
+		}
+
+		SnapshotView(const SnapshotView&) = delete;
+		SnapshotView& operator=(const SnapshotView&) = delete;
+
+		~SnapshotView()
+		{
+			unmap();
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		bool empty() const
+		{
+			return count == 0;
+		}
+
+		const TValue& find(const TKey& key) const
+		{
+			size_t index = lowerBound(key);
+
+			if (index == count || comp(key, keys[index]))
+				throw std::exception("Cannot find node");
+
+			return values[index];
+		}
+
+		bool contains(const TKey& key) const
+		{
+			size_t index = lowerBound(key);
+			return index < count && !comp(key, keys[index]);
+		}
+
+		std::pair<const TKey&, const TValue&> min() const
+		{
+			if (count == 0)
+				throw std::exception("Cannot find node");
+
+			return std::pair<const TKey&, const TValue&>(keys[0], values[0]);
+		}
+
+		std::pair<const TKey&, const TValue&> max() const
+		{
+			if (count == 0)
+				throw std::exception("Cannot find node");
+
+			return std::pair<const TKey&, const TValue&>(keys[count - 1], values[count - 1]);
+		}
+
+		// Index of the first key not less than key, size() if there is none.
+		size_t lowerBound(const TKey& key) const
+		{
+			if (count == 0)
+				return 0;
+
+			const TKey* base = keys;
+			size_t n = count;
+
+			while (n > 1)
+			{
+				size_t half = n / 2;
+				base = comp(base[half], key) ? base + half : base;
+				n -= half;
+			}
+
+			return (base - keys) + (comp(*base, key) ? 1 : 0);
+		}
+
+		const TKey* keyData() const
+		{
+			return keys;
+		}
+
+		const TValue* valueData() const
+		{
+			return values;
+		}
+
+	private:
+		void map(const std::string& fileName);
+
+		void unmap();
+
+	private:
+		TComp comp;
+		const char* data;
+		size_t length;
+		size_t count;
+		const TKey* keys;
+		const TValue* values;
+#ifdef _WIN32
+		HANDLE file;
+		HANDLE mapping;
+#endif
+	};
+
+#ifdef _WIN32
+	template <typename TKey, typename TValue, typename TComp>
+	void SnapshotView<TKey, TValue, TComp>::map(const std::string& fileName)
+	{
+		file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::exception("Cannot open snapshot");
+
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(file, &fileSize);
+		length = static_cast<size_t>(fileSize.QuadPart);
+
+		mapping = length == 0 ? nullptr : CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr)
+			data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (data == nullptr)
+		{
+			unmap();
+			throw std::exception("Cannot map snapshot");
+		}
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void SnapshotView<TKey, TValue, TComp>::unmap()
+	{
+		if (data != nullptr)
+			UnmapViewOfFile(data);
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		CloseHandle(file);
+
+		data = nullptr;
+	}
+#else
+	template <typename TKey, typename TValue, typename TComp>
+	void SnapshotView<TKey, TValue, TComp>::map(const std::string& fileName)
+	{
+		int fd = ::open(fileName.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::exception("Cannot open snapshot");
+
+		struct stat info;
+		if (fstat(fd, &info) == 0 && info.st_size > 0)
+		{
+			length = static_cast<size_t>(info.st_size);
+			void* address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+			data = address == MAP_FAILED ? nullptr : static_cast<const char*>(address);
+		}
+
+		::close(fd);
+
+		if (data == nullptr)
+			throw std::exception("Cannot map snapshot");
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void SnapshotView<TKey, TValue, TComp>::unmap()
+	{
+		if (data != nullptr)
+			munmap(const_cast<char*>(data), length);
+
+		data = nullptr;
+	}
+#endif
+}
@@ -0,0 +1,406 @@
+#pragma once
+
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "TreeWalk.h"
+
+namespace algs {
+
+	// Self-adjusting search tree (Sleator, Tarjan) with the same queries as RBTree.
+	// Every access splays the node it finds to the root, so under skewed access
+	// the hot keys sit a few levels from the top and cost O(log(1 / frequency))
+	// amortized instead of the full depth. Splaying is top-down, in one pass
+	// without parent pointers or recursion.
+	// Lookups reshape the tree: const methods are not safe to call concurrently.
+	template <
+		typename TKey,
+		typename TValue,
+		typename TComp = std::less<TKey>
+	>
+	class SplayTree
+	{
+		struct Node
+		{
+			Node* left;
+			Node* right;
+
+			std::pair<TKey, TValue> keyValue;
+
+			Node(const TKey& key, const TValue& value) :
+				left(nullptr),
+				right(nullptr),
+				keyValue(key, value)
+			{ }
+
+			const TKey& key() const { return keyValue.first; }
+
+			TValue& value() { return keyValue.second; }
+
+			const TValue& value() const { return keyValue.second; }
+		};
+
+	public:
+		explicit SplayTree() :
+			root(nullptr),
+			comp(),
+			count(0)
+		{}
+
+		explicit SplayTree(const TComp& comp) :
+			root(nullptr),
+			comp(comp),
+			count(0)
+		{}
+
+		SplayTree(const SplayTree&) = delete;
+		SplayTree& operator=(const SplayTree&) = delete;
+
+		~SplayTree()
+		{
+			clean(root);
+		}
+
+		const TValue& find(const TKey& key) const
+		{
+			return findRoot(key)->value();
+		}
+
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		const TValue& find(const TLookup& key) const
+		{
+			return findRoot(key)->value();
+		}
+
+		bool contains(const TKey& key) const
+		{
+			return access(key) != nullptr;
+		}
+
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		bool contains(const TLookup& key) const
+		{
+			return access(key) != nullptr;
+		}
+
+		std::pair<const TKey&, TValue&> min() const
+		{
+			if (root == nullptr)
+				throw std::exception("Cannot find node");
+
+			root = splay(root, [](const Node*) { return -1; });
+			return std::pair<const TKey&, TValue&>(root->key(), root->value());
+		}
+
+		std::pair<const TKey&, TValue&> max() const
+		{
+			if (root == nullptr)
+				throw std::exception("Cannot find node");
+
+			root = splay(root, [](const Node*) { return 1; });
+			return std::pair<const TKey&, TValue&>(root->key(), root->value());
+		}
+
+		const TKey& successor(const TKey& key) const
+		{
+			Node* node = findRoot(key);
+
+			if (node->right == nullptr)
+				throw std::exception("Cannot find successor");
+
+			return findMinNode(node->right)->key();
+		}
+
+		const TKey& predecessor(const TKey& key) const
+		{
+			Node* node = findRoot(key);
+
+			if (node->left == nullptr)
+				throw std::exception("Cannot find predecessor");
+
+			return findMaxNode(node->left)->key();
+		}
+
+		void insert(const TKey& key, const TValue& value);
+
+		void remove(const TKey& key);
+
+		void print() const
+		{
+			forEach([](const TKey& key, const TValue& value)
+			{
+				std::cout << key << "(" << value << ") ";
+			});
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		bool empty() const
+		{
+			return count == 0;
+		}
+
+		// Calls visit(key, value) for every entry in key order. Does not splay.
+		template <typename TFunc>
+		void forEach(TFunc visit) const;
+
+		size_t height() const;
+
+	private:
+		// Top-down splay of the subtree t. direction(node) returns a negative number
+		// to go left, a positive one to go right and 0 to stop there; the last node
+		// reached becomes the root of the result. Each node on the path is asked once.
+		template <typename TDirection>
+		static Node* splay(Node* t, TDirection direction);
+
+		// Splays the node with key, or the last node on its search path, to the root.
+		template <typename TLookup>
+		bool splayTo(const TLookup& key) const
+		{
+			if (root == nullptr)
+				return false;
+
+			root = splay(root, [this, &key](const Node* node)
+			{
+				return comp(key, node->key()) ? -1 : comp(node->key(), key) ? 1 : 0;
+			});
+
+			return !comp(key, root->key()) && !comp(root->key(), key);
+		}
+
+		// A hit on the root is read without writes; anything else is splayed in the
+		// same top-down pass that searches for it.
+		template <typename TLookup>
+		Node* access(const TLookup& key) const
+		{
+			if (root == nullptr)
+				return nullptr;
+
+			if (!comp(key, root->key()) && !comp(root->key(), key))
+				return root;
+
+			return splayTo(key) ? root : nullptr;
+		}
+
+		template <typename TLookup>
+		Node* findRoot(const TLookup& key) const
+		{
+			if (!splayTo(key))
+				throw std::exception("Cannot find node");
+
+			return root;
+		}
+
+		static Node* findMinNode(Node* node)
+		{
+			while (node->left != nullptr)
+				node = node->left;
+
+			return node;
+		}
+
+		static Node* findMaxNode(Node* node)
+		{
+			while (node->right != nullptr)
+				node = node->right;
+
+			return node;
+		}
+
+		static void clean(Node* node)
+		{
+			// Rotate left children up until the tree is a right-leaning list,
+			// deleting nodes as they reach the head of the list.
+			while (node != nullptr)
+			{
+				if (node->left != nullptr)
+				{
+					Node* child = node->left;
+					node->left = child->right;
+					child->right = node;
+					node = child;
+				}
+				else
+				{
+					Node* next = node->right;
+					delete node;
+					node = next;
+				}
+			}
+		}
+
+	private:
+		// Lookups move the accessed node to the root.
+		mutable Node* root;
+		TComp comp;
+		size_t count;
+	};
+
+	template <typename TKey, typename TValue, typename TComp>
+	template <typename TDirection>
+	typename SplayTree<TKey, TValue, TComp>::Node* SplayTree<TKey, TValue, TComp>::splay(Node* t, TDirection direction)
+	{
+		// Nodes passed on the way down are hung on two side trees: smaller ones on the
+		// right spine of the left tree, larger ones on the left spine of the right tree.
+		Node* leftTree = nullptr;
+		Node* rightTree = nullptr;
+		Node** leftHook = &leftTree;
+		Node** rightHook = &rightTree;
+
+		int turn = direction(t);
+
+		while (turn != 0)
+		{
+			if (turn < 0)
+			{
+				if (t->left == nullptr)
+					break;
+
+				int next = direction(t->left);
+
+				// Zig-zig: rotate right before linking.
+				if (next < 0)
+				{
+					Node* child = t->left;
+					t->left = child->right;
+					child->right = t;
+					t = child;
+
+					if (t->left == nullptr)
+						break;
+
+					*rightHook = t;
+					rightHook = &t->left;
+					t = t->left;
+					turn = direction(t);
+				}
+				else
+				{
+					*rightHook = t;
+					rightHook = &t->left;
+					t = t->left;
+					turn = next;
+				}
+			}
+			else
+			{
+				if (t->right == nullptr)
+					break;
+
+				int next = direction(t->right);
+
+				// Zag-zag: rotate left before linking.
+				if (next > 0)
+				{
+					Node* child = t->right;
+					t->right = child->left;
+					child->left = t;
+					t = child;
+
+					if (t->right == nullptr)
+						break;
+
+					*leftHook = t;
+					leftHook = &t->right;
+					t = t->right;
+					turn = direction(t);
+				}
+				else
+				{
+					*leftHook = t;
+					leftHook = &t->right;
+					t = t->right;
+					turn = next;
+				}
+			}
+		}
+
+		*leftHook = t->left;
+		*rightHook = t->right;
+		t->left = leftTree;
+		t->right = rightTree;
+
+		return t;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void SplayTree<TKey, TValue, TComp>::insert(const TKey& key, const TValue& value)
+	{
+		Node* newNode = new Node(key, value);
+		count++;
+
+		if (root == nullptr)
+		{
+			root = newNode;
+			return;
+		}
+
+		// The new node becomes the root, with the old one on the side it belongs to.
+		splayTo(key);
+
+		if (comp(key, root->key()))
+		{
+			newNode->left = root->left;
+			newNode->right = root;
+			root->left = nullptr;
+		}
+		else
+		{
+			newNode->right = root->right;
+			newNode->left = root;
+			root->right = nullptr;
+		}
+
+		root = newNode;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	void SplayTree<TKey, TValue, TComp>::remove(const TKey& key)
+	{
+		if (!splayTo(key))
+			return;
+
+		Node* node = root;
+
+		// Splaying the largest node of the left subtree leaves it without a right
+		// child, so the right subtree can hang there.
+		if (node->left == nullptr)
+		{
+			root = node->right;
+		}
+		else
+		{
+			root = splay(node->left, [](const Node*) { return 1; });
+			root->right = node->right;
+		}
+
+		delete node;
+		count--;
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	template <typename TFunc>
+	void SplayTree<TKey, TValue, TComp>::forEach(TFunc visit) const
+	{
+		detail::forEachInOrder(root, [&visit](const Node* node) { visit(node->key(), node->value()); });
+	}
+
+	template <typename TKey, typename TValue, typename TComp>
+	size_t SplayTree<TKey, TValue, TComp>::height() const
+	{
+		return detail::treeHeight(root);
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <functional>
+#include <type_traits>
+
+namespace algs {
+
+	// Augmentation policies for RBTree. With a policy other than NoAugment every
+	// node also stores a summary of its whole subtree, kept up to date by insert,
+	// remove, the rotations of the fixups and the bulk rebuilds, at O(1) extra
+	// work per node touched. A policy defines
+	//
+	//   typedef ... Summary;
+	//   Summary entry(const TKey& key, const TValue& value) const;
+	//   Summary combine(const Summary& left, const Summary& right) const;
+	//
+	// entry() summarizes a single entry and combine() joins the summaries of two
+	// neighbouring key ranges, left one first. combine() must be associative;
+	// it does not have to be commutative and no identity element is needed.
+
+	struct NoAugment
+	{
+		struct Summary {};
+
+		template <typename TKey, typename TValue>
+		Summary entry(const TKey&, const TValue&) const
+		{
+			return Summary();
+		}
+
+		Summary combine(const Summary&, const Summary&) const
+		{
+			return Summary();
+		}
+	};
+
+	// Storage for a node's summary. Tree nodes derive from it, so an empty
+	// summary such as NoAugment's takes no space: all nodes share one static
+	// instance that is never read.
+	template <
+		typename TSummary,
+		bool = std::is_empty<TSummary>::value
+	>
+	struct SummaryField
+	{
+		TSummary summary;
+	};
+
+	template <typename TSummary>
+	struct SummaryField<TSummary, true>
+	{
+		static TSummary summary;
+	};
+
+	template <typename TSummary>
+	TSummary SummaryField<TSummary, true>::summary;
+
+	// Sum of the values.
+	template <typename TValue>
+	struct SumAugment
+	{
+		typedef TValue Summary;
+
+		template <typename TKey>
+		Summary entry(const TKey&, const TValue& value) const
+		{
+			return value;
+		}
+
+		Summary combine(const Summary& left, const Summary& right) const
+		{
+			return left + right;
+		}
+	};
+
+	// Smallest value in the order of TComp.
+	template <
+		typename TValue,
+		typename TComp = std::less<TValue>
+	>
+	struct MinAugment
+	{
+		typedef TValue Summary;
+
+		explicit MinAugment(const TComp& comp = TComp()) :
+			comp(comp)
+		{
+		}
+
+		template <typename TKey>
+		Summary entry(const TKey&, const TValue& value) const
+		{
+			return value;
+		}
+
+		Summary combine(const Summary& left, const Summary& right) const
+		{
+			return comp(right, left) ? right : left;
+		}
+
+		TComp comp;
+	};
+}
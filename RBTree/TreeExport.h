@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace algs {
+namespace treeExport {
+
+	// Output goes through one large user-space buffer and is never flushed per line.
+	const size_t bufferSize = 1 << 20;
+
+	const size_t unlimitedDepth = static_cast<size_t>(-1);
+
+	// Flag bits of a node record in the binary format.
+	enum BinaryFlags : uint8_t
+	{
+		hasLeft = 1,
+		hasRight = 2,
+		isRed = 4,
+		leftTruncated = 8,
+		rightTruncated = 16
+	};
+
+	// Attaches buffer to file before opening it. The buffer has to outlive the
+	// stream, which flushes into it on close.
+	inline void open(std::ofstream& file, std::vector<char>& buffer, const std::string& fileName, std::ios_base::openmode mode = std::ios_base::out)
+	{
+		buffer.resize(bufferSize);
+		file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+		file.open(fileName, mode);
+	}
+
+	// Binary header: magic, format version, sizeof(TKey) and the number of
+	// extra bytes stored per node. Records follow in preorder.
+	inline void writeBinaryHeader(std::ofstream& file, uint8_t keySize, uint8_t extraSize)
+	{
+		const char header[] = { 'T', 'R', 'E', 'E', 1, static_cast<char>(keySize), static_cast<char>(extraSize) };
+		file.write(header, sizeof(header));
+	}
+
+	// Preorder walk over parent pointers starting at subtreeRoot: no recursion and
+	// no auxiliary storage. Calls visit(node, depth) with depth 1 for subtreeRoot and
+	// does not descend below maxDepth. nil is the tree's leaf marker and parentOf(node)
+	// reads a node's parent.
+	template <typename TNode, typename TParent, typename TFunc>
+	void walk(TNode* subtreeRoot, TNode* nil, size_t maxDepth, TParent parentOf, TFunc visit)
+	{
+		if (subtreeRoot == nil || maxDepth == 0)
+			return;
+
+		TNode* stop = parentOf(subtreeRoot);
+		TNode* prev = stop;
+		TNode* node = subtreeRoot;
+		size_t depth = 1;
+
+		while (node != stop)
+		{
+			bool expand = depth < maxDepth;
+			TNode* next;
+
+			if (prev == parentOf(node))
+			{
+				visit(node, depth);
+
+				if (expand && node->left != nil)
+					next = node->left;
+				else if (expand && node->right != nil)
+					next = node->right;
+				else
+					next = parentOf(node);
+			}
+			else if (prev == node->left && expand && node->right != nil)
+			{
+				next = node->right;
+			}
+			else
+			{
+				next = parentOf(node);
+			}
+
+			if (next == parentOf(node))
+				depth--;
+			else
+				depth++;
+
+			prev = node;
+			node = next;
+		}
+	}
+}
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "TreeExport.h"
+
+namespace algs {
+namespace snapshot {
+
+	// File layout: the header, all keys in order, then all values in the same order,
+	// each starting on a multiple of alignment and padded with zeros before it. Keys
+	// and values are stored raw, so both have to be trivially copyable.
+	// No tree shape is stored: load() rebuilds a perfectly balanced tree from the
+	// sorted entries, which is at least as good as any shape a live tree had.
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t keySize;
+		uint32_t valueSize;
+		uint64_t count;
+	};
+
+	// Version 1 stored the keys right after the 24-byte header.
+	const uint32_t version = 2;
+	const size_t alignment = 16;
+
+	inline size_t alignUp(size_t offset)
+	{
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+
+	inline size_t keysOffset()
+	{
+		return alignUp(sizeof(Header));
+	}
+
+	inline size_t valuesOffset(size_t count, size_t keySize)
+	{
+		return alignUp(keysOffset() + count * keySize);
+	}
+
+	// Whether header describes a snapshot of length bytes with keys and values of
+	// the given sizes.
+	inline bool valid(const Header& header, size_t length, size_t keySize, size_t valueSize)
+	{
+		return length >= sizeof(Header)
+			&& std::memcmp(header.magic, "SNAP", 4) == 0
+			&& header.version == version
+			&& header.keySize == keySize
+			&& header.valueSize == valueSize
+			&& length >= valuesOffset(static_cast<size_t>(header.count), keySize) + static_cast<size_t>(header.count) * valueSize;
+	}
+
+	// Writes any tree exposing size() and an in-order forEach(), in two passes.
+	template <typename TKey, typename TValue, typename TTree>
+	void write(const std::string& fileName, const TTree& tree)
+	{
+		static_assert(std::is_trivially_copyable<TKey>::value, "Snapshots need trivially copyable keys");
+		static_assert(std::is_trivially_copyable<TValue>::value, "Snapshots need trivially copyable values");
+		static_assert(alignof(TKey) <= alignment && alignof(TValue) <= alignment, "Snapshots align keys and values to 16 bytes at most");
+
+		std::vector<char> buffer;
+		std::ofstream file;
+		treeExport::open(file, buffer, fileName, std::ios_base::out | std::ios_base::binary);
+
+		if (!file)
+			throw std::exception("Cannot open snapshot");
+
+		Header header = { { 'S', 'N', 'A', 'P' }, version, sizeof(TKey), sizeof(TValue), tree.size() };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		const char zeros[alignment] = {};
+		file.write(zeros, keysOffset() - sizeof(Header));
+
+		tree.forEach([&file](const TKey& key, const TValue&)
+		{
+			file.write(reinterpret_cast<const char*>(&key), sizeof(TKey));
+		});
+
+		file.write(zeros, valuesOffset(tree.size(), sizeof(TKey)) - keysOffset() - tree.size() * sizeof(TKey));
+
+		tree.forEach([&file](const TKey&, const TValue& value)
+		{
+			file.write(reinterpret_cast<const char*>(&value), sizeof(TValue));
+		});
+
+		file.flush();
+		if (!file)
+			throw std::exception("Cannot write snapshot");
+	}
+
+	// Reads a whole snapshot into keys and values with plain file reads. Use
+	// SnapshotView to serve lookups from the file without reading it.
+	template <typename TKey, typename TValue>
+	void read(const std::string& fileName, std::vector<TKey>& keys, std::vector<TValue>& values)
+	{
+		static_assert(std::is_trivially_copyable<TKey>::value, "Snapshots need trivially copyable keys");
+		static_assert(std::is_trivially_copyable<TValue>::value, "Snapshots need trivially copyable values");
+
+		std::ifstream file(fileName, std::ios_base::in | std::ios_base::binary);
+		if (!file)
+			throw std::exception("Cannot open snapshot");
+
+		file.seekg(0, std::ios_base::end);
+		size_t length = static_cast<size_t>(file.tellg());
+		file.seekg(0, std::ios_base::beg);
+
+		Header header = {};
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		if (!file || !valid(header, length, sizeof(TKey), sizeof(TValue)))
+			throw std::exception("Invalid snapshot");
+
+		size_t count = static_cast<size_t>(header.count);
+		keys.resize(count);
+		values.resize(count);
+
+		file.seekg(keysOffset());
+		file.read(reinterpret_cast<char*>(keys.data()), count * sizeof(TKey));
+		file.seekg(valuesOffset(count, sizeof(TKey)));
+		file.read(reinterpret_cast<char*>(values.data()), count * sizeof(TValue));
+
+		if (!file)
+			throw std::exception("Cannot read snapshot");
+	}
+}
+}
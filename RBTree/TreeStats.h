@@ -0,0 +1,64 @@
+#pragma once
+
+#include <future>
+#include <vector>
+
+namespace algs {
+
+	// Maintained on every insert and remove, or read off the root in O(log n):
+	// cheap enough to poll once a second on a live tree.
+	struct TreeCounters
+	{
+		size_t nodeCount;
+
+		// Depth at which the latest insert placed its node, root at 1.
+		size_t lastInsertDepth;
+
+		// Deepest insert since the tree was created, measured before rebalancing.
+		// A jump here flags a depth regression without an O(n) walk.
+		size_t maxInsertDepth;
+
+		// Black nodes on every root-to-leaf path, RBTree only.
+		size_t blackHeight;
+
+		// Share of the nodes that sit in the larger root subtree, RandomizedBST only:
+		// 0.5 for a perfect split, close to 1 for a degenerate tree.
+		double rootImbalance;
+
+		size_t bytesPerNode;
+	};
+
+	// Full shape of the tree, computed in one O(n) walk.
+	struct TreeStats
+	{
+		size_t nodeCount;
+		size_t height;
+
+		// Mean depth of a node, i.e. the average cost of a successful search.
+		// The maximum search depth is the height.
+		double averageDepth;
+
+		// depthHistogram[d] is the number of nodes at depth d + 1.
+		std::vector<size_t> depthHistogram;
+
+		// RBTree only.
+		size_t blackHeight;
+
+		// RandomizedBST only: size-weighted share of each subtree taken by its
+		// larger child, 0.5 for a perfectly balanced tree and 1 for a list.
+		double sizeImbalance;
+
+		size_t bytesPerNode;
+	};
+
+	// Runs tree.stats() on a separate thread. Readers may keep using the tree,
+	// but it must not be modified until the future is ready.
+	template <typename TTree>
+	std::future<TreeStats> statsAsync(const TTree& tree)
+	{
+		return std::async(std::launch::async, [&tree]()
+		{
+			return tree.stats();
+		});
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace algs {
+
+	namespace detail {
+
+		// Walks for trees whose nodes only link to their children (SplayTree, ZipTree).
+		// Without parent pointers the pending nodes are kept on an explicit stack.
+
+		// Calls visit(node) for every node of the tree in key order.
+		template <typename TNode, typename TFunc>
+		void forEachInOrder(const TNode* root, TFunc visit)
+		{
+			std::vector<const TNode*> stack;
+			const TNode* node = root;
+
+			while (node != nullptr || !stack.empty())
+			{
+				for (; node != nullptr; node = node->left)
+					stack.push_back(node);
+
+				node = stack.back();
+				stack.pop_back();
+
+				visit(node);
+				node = node->right;
+			}
+		}
+
+		// Calls visit(node, depth) for every node of the tree, root at depth 1, in preorder.
+		template <typename TNode, typename TFunc>
+		void forEachWithDepth(const TNode* root, TFunc visit)
+		{
+			std::vector<std::pair<const TNode*, size_t>> stack;
+
+			if (root != nullptr)
+				stack.push_back(std::make_pair(root, size_t(1)));
+
+			while (!stack.empty())
+			{
+				const TNode* node = stack.back().first;
+				size_t depth = stack.back().second;
+				stack.pop_back();
+
+				// Follow left children inline and defer right ones.
+				while (node != nullptr)
+				{
+					visit(node, depth);
+
+					if (node->right != nullptr)
+						stack.push_back(std::make_pair(node->right, depth + 1));
+
+					node = node->left;
+					depth++;
+				}
+			}
+		}
+
+		template <typename TNode>
+		size_t treeHeight(const TNode* root)
+		{
+			size_t h = 0;
+			forEachWithDepth(root, [&h](const TNode*, size_t depth) { h = std::max(h, depth); });
+			return h;
+		}
+	}
+}
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "TreeWalk.h"
+#include "Random.h"
+
+namespace algs {
+
+	// Zip tree (Tarjan, Levy, Timmel): a treap whose priorities are small ranks.
+	// Each node draws its rank once, on insert, and the tree is kept heap-ordered by
+	// rank, with equal ranks broken by key, for O(log n) expected depth. Ranks follow
+	// the zip-zip variant (Gila, Goodrich, Tarjan): a geometric part with a uniform
+	// byte below it, which makes ties rare and brings the depth close to a treap's.
+	// Updates need no rotations: insert unzips the path below the new node in one
+	// top-down pass, remove zips the two subtrees back together, and there are no
+	// parent pointers or subtree sizes to maintain. Like RBTree, equal keys are kept
+	// in insertion order.
+	template <
+		typename TKey,
+		typename TValue,
+		typename TComp = std::less<TKey>,
+		typename TRandom = WyRand
+	>
+	class ZipTree
+	{
+		struct Node
+		{
+			Node* left;
+			Node* right;
+
+			std::pair<TKey, TValue> keyValue;
+
+			unsigned short rank;
+
+			Node(const TKey& key, const TValue& value, unsigned short rank) :
+				left(nullptr),
+				right(nullptr),
+				keyValue(key, value),
+				rank(rank)
+			{ }
+
+			const TKey& key() const { return keyValue.first; }
+
+			TValue& value() { return keyValue.second; }
+
+			const TValue& value() const { return keyValue.second; }
+		};
+
+	public:
+		explicit ZipTree() :
+			root(nullptr),
+			comp(),
+			count(0)
+		{}
+
+		explicit ZipTree(const TComp& comp) :
+			root(nullptr),
+			comp(comp),
+			count(0)
+		{}
+
+		explicit ZipTree(const TComp& comp, const TRandom& random) :
+			root(nullptr),
+			comp(comp),
+			random(random),
+			count(0)
+		{}
+
+		ZipTree(const ZipTree&) = delete;
+		ZipTree& operator=(const ZipTree&) = delete;
+
+		~ZipTree()
+		{
+			clean(root);
+		}
+
+		const TValue& find(const TKey& key) const
+		{
+			Node* ptr = findNode(key);
+
+			if (ptr == nullptr)
+				throw std::exception("Cannot find node");
+
+			return ptr->value();
+		}
+
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		const TValue& find(const TLookup& key) const
+		{
+			Node* ptr = findNode(key);
+
+			if (ptr == nullptr)
+				throw std::exception("Cannot find node");
+
+			return ptr->value();
+		}
+
+		bool contains(const TKey& key) const
+		{
+			return findNode(key) != nullptr;
+		}
+
+		template <
+			typename TLookup,
+			typename TComp1 = TComp,
+			typename = typename TComp1::is_transparent
+		>
+		bool contains(const TLookup& key) const
+		{
+			return findNode(key) != nullptr;
+		}
+
+		std::pair<const TKey&, TValue&> min() const
+		{
+			if (root == nullptr)
+				throw std::exception("Cannot find node");
+
+			Node* ptr = findMinNode(root);
+			return std::pair<const TKey&, TValue&>(ptr->key(), ptr->value());
+		}
+
+		std::pair<const TKey&, TValue&> max() const
+		{
+			if (root == nullptr)
+				throw std::exception("Cannot find node");
+
+			Node* ptr = findMaxNode(root);
+			return std::pair<const TKey&, TValue&>(ptr->key(), ptr->value());
+		}
+
+		const TKey& successor(const TKey& key) const;
+
+		const TKey& predecessor(const TKey& key) const;
+
+		void insert(const TKey& key, const TValue& value);
+
+		void remove(const TKey& key);
+
+		void print() const
+		{
+			forEach([](const TKey& key, const TValue& value)
+			{
+				std::cout << key << "(" << value << ") ";
+			});
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		bool empty() const
+		{
+			return count == 0;
+		}
+
+		// Calls visit(key, value) for every entry in key order.
+		template <typename TFunc>
+		void forEach(TFunc visit) const;
+
+		size_t height() const;
+
+	private:
+		// The high byte is geometric: the number of trailing ones of a random word,
+		// 0 with probability 1/2, 1 with probability 1/4 and so on. The low byte is
+		// uniform, taken from the top of the same word.
+		unsigned short randomRank()
+		{
+			uint32_t bits = random();
+			unsigned short uniformPart = static_cast<unsigned short>(bits >> 24);
+			unsigned short geometricPart = 0;
+
+			while ((bits & 1) && geometricPart < 24)
+			{
+				geometricPart++;
+				bits >>= 1;
+			}
+
+			return static_cast<unsigned short>((geometricPart << 8) | uniformPart);
+		}
+
+		static void clean(Node* node)
+		{
+			// Rotate left children up until the tree is a right-leaning list,
+			// deleting nodes as they reach the head of the list.
+			while (node != nullptr)
+			{
+				if (node->left != nullptr)
+				{
+					Node* child = node->left;
+					node->left = child->right;
+					child->right = node;
+					node = child;
+				}
+				else
+				{
+					Node* next = node->right;
+					delete node;
+					node = next;
+				}
+			}
+		}
+
+		template <typename TLookup>
+		Node* findNode(const TLookup& key) const
+		{
+			Node* ptr = root;
+
+			while (ptr != nullptr)
+			{
+				if (comp(key, ptr->key()))
+					ptr = ptr->left;
+				else if (comp(ptr->key(), key))
+					ptr = ptr->right;
+				else
+					break;
+			}
+
+			return ptr;
+		}
+
+		static Node* findMinNode(Node* node)
+		{
+			while (node->left != nullptr)
+				node = node->left;
+
+			return node;
+		}
+
+		static Node* findMaxNode(Node* node)
+		{
+			while (node->right != nullptr)
+				node = node->right;
+
+			return node;
+		}
+
+	private:
+		Node* root;
+		TComp comp;
+		TRandom random;
+		size_t count;
+	};
+
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	void ZipTree<TKey, TValue, TComp, TRandom>::insert(const TKey& key, const TValue& value)
+	{
+		Node* newNode = new Node(key, value, randomRank());
+
+		// Descend to the first node the new one outranks. Equal ranks are ordered by key,
+		// the smaller key on top, and an equal key counts as smaller, so it goes right.
+		Node** link = &root;
+		Node* current = root;
+
+		while (current != nullptr
+			&& (current->rank > newNode->rank || (current->rank == newNode->rank && !comp(key, current->key()))))
+		{
+			link = comp(key, current->key()) ? &current->left : &current->right;
+			current = *link;
+		}
+
+		*link = newNode;
+
+		// Unzip: split the path below into the nodes that go left of the new node
+		// and those that go right of it, keeping their relative order.
+		Node** leftLink = &newNode->left;
+		Node** rightLink = &newNode->right;
+
+		while (current != nullptr)
+		{
+			if (comp(key, current->key()))
+			{
+				*rightLink = current;
+				rightLink = &current->left;
+				current = current->left;
+			}
+			else
+			{
+				*leftLink = current;
+				leftLink = &current->right;
+				current = current->right;
+			}
+		}
+
+		*leftLink = nullptr;
+		*rightLink = nullptr;
+		count++;
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	void ZipTree<TKey, TValue, TComp, TRandom>::remove(const TKey& key)
+	{
+		Node** link = &root;
+		Node* node = root;
+
+		while (node != nullptr)
+		{
+			if (comp(key, node->key()))
+				link = &node->left;
+			else if (comp(node->key(), key))
+				link = &node->right;
+			else
+				break;
+
+			node = *link;
+		}
+
+		if (node == nullptr)
+			return;
+
+		// Zip: merge the right spine of the left subtree with the left spine of the
+		// right subtree by rank. On equal ranks the left node, with the smaller key, stays on top.
+		Node* left = node->left;
+		Node* right = node->right;
+
+		while (left != nullptr && right != nullptr)
+		{
+			if (left->rank >= right->rank)
+			{
+				*link = left;
+				link = &left->right;
+				left = left->right;
+			}
+			else
+			{
+				*link = right;
+				link = &right->left;
+				right = right->left;
+			}
+		}
+
+		*link = left != nullptr ? left : right;
+
+		delete node;
+		count--;
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	const TKey& ZipTree<TKey, TValue, TComp, TRandom>::successor(const TKey& key) const
+	{
+		// No parent pointers: remember the last node where the search turned left.
+		const Node* candidate = nullptr;
+		Node* ptr = root;
+
+		while (ptr != nullptr)
+		{
+			if (comp(key, ptr->key()))
+			{
+				candidate = ptr;
+				ptr = ptr->left;
+			}
+			else if (comp(ptr->key(), key))
+			{
+				ptr = ptr->right;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		if (ptr == nullptr)
+			throw std::exception("Cannot find node");
+
+		if (ptr->right != nullptr)
+			return findMinNode(ptr->right)->key();
+
+		if (candidate == nullptr)
+			throw std::exception("Cannot find successor");
+
+		return candidate->key();
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	const TKey& ZipTree<TKey, TValue, TComp, TRandom>::predecessor(const TKey& key) const
+	{
+		// Mirror of successor(): remember the last node where the search turned right.
+		const Node* candidate = nullptr;
+		Node* ptr = root;
+
+		while (ptr != nullptr)
+		{
+			if (comp(key, ptr->key()))
+			{
+				ptr = ptr->left;
+			}
+			else if (comp(ptr->key(), key))
+			{
+				candidate = ptr;
+				ptr = ptr->right;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		if (ptr == nullptr)
+			throw std::exception("Cannot find node");
+
+		if (ptr->left != nullptr)
+			return findMaxNode(ptr->left)->key();
+
+		if (candidate == nullptr)
+			throw std::exception("Cannot find predecessor");
+
+		return candidate->key();
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	template <typename TFunc>
+	void ZipTree<TKey, TValue, TComp, TRandom>::forEach(TFunc visit) const
+	{
+		detail::forEachInOrder(root, [&visit](const Node* node) { visit(node->key(), node->value()); });
+	}
+
+	template <typename TKey, typename TValue, typename TComp, typename TRandom>
+	size_t ZipTree<TKey, TValue, TComp, TRandom>::height() const
+	{
+		return detail::treeHeight(root);
+	}
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace algs {
+
+	namespace detail {
+
+		// Sorts (key, index) pairs, ties broken by index so equal keys keep their order,
+		// and returns the indices: the permutation that sorts the keys.
+		template <typename TIndex, typename RandomAccessIterator, typename KeyOf, typename Compare>
+		std::vector<size_t> sortKeyIndex(RandomAccessIterator first, size_t n, KeyOf keyOf, Compare comp)
+		{
+			using Key = typename std::decay<decltype(keyOf(*first))>::type;
+			using Entry = std::pair<Key, TIndex>;
+
+			std::vector<Entry> entries;
+			entries.reserve(n);
+			for (size_t i = 0; i < n; i++)
+				entries.push_back(Entry(keyOf(first[i]), static_cast<TIndex>(i)));
+
+			std::sort(entries.begin(), entries.end(), [&comp](const Entry& left, const Entry& right)
+			{
+				if (comp(left.first, right.first))
+					return true;
+				if (comp(right.first, left.first))
+					return false;
+				return left.second < right.second;
+			});
+
+			std::vector<size_t> permutation(n);
+			for (size_t i = 0; i < n; i++)
+				permutation[i] = entries[i].second;
+
+			return permutation;
+		}
+
+		// Sorts the indices themselves, comparing the elements they refer to, ties broken
+		// by index. For whole elements as keys, which sortKeyIndex would copy in full.
+		template <typename TIndex, typename RandomAccessIterator, typename Compare>
+		std::vector<size_t> sortIndex(RandomAccessIterator first, size_t n, Compare comp)
+		{
+			std::vector<TIndex> indices(n);
+			for (size_t i = 0; i < n; i++)
+				indices[i] = static_cast<TIndex>(i);
+
+			std::sort(indices.begin(), indices.end(), [first, &comp](TIndex left, TIndex right)
+			{
+				if (comp(first[left], first[right]))
+					return true;
+				if (comp(first[right], first[left]))
+					return false;
+				return left < right;
+			});
+
+			return std::vector<size_t>(indices.begin(), indices.end());
+		}
+	}
+
+	// Stable indirect sort: returns the permutation p such that first[p[0]], first[p[1]], ...
+	// is sorted, leaving the range untouched. Only the keys that keyOf(element) extracts
+	// are copied, next to a 32-bit index where the size allows, so the sort moves compact
+	// pairs around instead of whole records and never reaches back into the range.
+	template <typename RandomAccessIterator, typename KeyOf, typename Compare>
+	std::vector<size_t> argsort(RandomAccessIterator first, RandomAccessIterator last, KeyOf keyOf, Compare comp)
+	{
+		size_t n = static_cast<size_t>(last - first);
+
+		if (n <= UINT32_MAX)
+			return detail::sortKeyIndex<uint32_t>(first, n, keyOf, comp);
+
+		return detail::sortKeyIndex<size_t>(first, n, keyOf, comp);
+	}
+
+	// Sorts by the whole element. Only indices are moved; the comparisons read the
+	// elements in place.
+	template <typename RandomAccessIterator, typename Compare>
+	std::vector<size_t> argsort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+	{
+		size_t n = static_cast<size_t>(last - first);
+
+		if (n <= UINT32_MAX)
+			return detail::sortIndex<uint32_t>(first, n, comp);
+
+		return detail::sortIndex<size_t>(first, n, comp);
+	}
+
+	template <typename RandomAccessIterator>
+	std::vector<size_t> argsort(RandomAccessIterator first, RandomAccessIterator last)
+	{
+		return argsort(first, last, std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>());
+	}
+
+	// Rearranges the range so that position i receives the element that was at
+	// permutation[i], as returned by argsort(). Follows the cycles of the permutation:
+	// an element already in place is not touched, every other one is moved exactly
+	// once, plus one move through a temporary per cycle. O(n) time, n bits of memory.
+	template <typename RandomAccessIterator>
+	void applyPermutation(RandomAccessIterator first, const std::vector<size_t>& permutation)
+	{
+		size_t n = permutation.size();
+		std::vector<bool> placed(n);
+
+		for (size_t start = 0; start < n; start++)
+		{
+			if (placed[start] || permutation[start] == start)
+				continue;
+
+			auto temp = std::move(first[start]);
+			size_t to = start;
+
+			for (size_t from = permutation[to]; from != start; from = permutation[to])
+			{
+				first[to] = std::move(first[from]);
+				placed[to] = true;
+				to = from;
+			}
+
+			first[to] = std::move(temp);
+			placed[to] = true;
+		}
+	}
+
+	// Sorts records by keyOf(record), stably, moving each record out of place once, plus
+	// one extra move per cycle of the permutation (see applyPermutation). Meant for large
+	// records, where std::sort and the Shell sorts would move each of them O(log n) times
+	// or more.
+	template <typename RandomAccessIterator, typename KeyOf, typename Compare>
+	void sortByKey(RandomAccessIterator first, RandomAccessIterator last, KeyOf keyOf, Compare comp)
+	{
+		applyPermutation(first, argsort(first, last, keyOf, comp));
+	}
+
+	// Sorts keys[] and applies the same reordering to values[], for data kept as a
+	// structure of arrays. Stable.
+	template <typename KeyIterator, typename ValueIterator, typename Compare>
+	void coSort(KeyIterator keysFirst, KeyIterator keysLast, ValueIterator valuesFirst, Compare comp)
+	{
+		std::vector<size_t> permutation = argsort(keysFirst, keysLast, comp);
+		applyPermutation(keysFirst, permutation);
+		applyPermutation(valuesFirst, permutation);
+	}
+
+	template <typename KeyIterator, typename ValueIterator>
+	void coSort(KeyIterator keysFirst, KeyIterator keysLast, ValueIterator valuesFirst)
+	{
+		coSort(keysFirst, keysLast, valuesFirst, std::less<typename std::iterator_traits<KeyIterator>::value_type>());
+	}
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include "SortingNetwork.h"
+#include "../PriorityQueue/HeapAlgorithms.h"
+
+namespace algs {
+
+	namespace detail {
+
+		// Ranges up to this size are finished with a sorting network.
+		constexpr size_t introSortThreshold = 16;
+
+		// Moves the median of *a, *b and *c to *result.
+		template <typename RandomAccessIterator, typename Compare>
+		void moveMedianToFirst(RandomAccessIterator result, RandomAccessIterator a, RandomAccessIterator b,
+			RandomAccessIterator c, Compare& comp)
+		{
+			if (comp(*a, *b))
+			{
+				if (comp(*b, *c))
+					std::iter_swap(result, b);
+				else if (comp(*a, *c))
+					std::iter_swap(result, c);
+				else
+					std::iter_swap(result, a);
+			}
+			else if (comp(*a, *c))
+				std::iter_swap(result, a);
+			else if (comp(*b, *c))
+				std::iter_swap(result, c);
+			else
+				std::iter_swap(result, b);
+		}
+
+		// Hoare partition of [first + 1, last) around the pivot in *first. No bounds
+		// checks in the scans: the median of three leaves an element not less and one
+		// not greater than the pivot on either side.
+		template <typename RandomAccessIterator, typename Compare>
+		RandomAccessIterator partitionAroundFirst(RandomAccessIterator first, RandomAccessIterator last, Compare& comp)
+		{
+			RandomAccessIterator left = first + 1;
+			RandomAccessIterator right = last;
+
+			for (;;)
+			{
+				while (comp(*left, *first))
+					++left;
+
+				--right;
+				while (comp(*first, *right))
+					--right;
+
+				if (!(left < right))
+					return left;
+
+				std::iter_swap(left, right);
+				++left;
+			}
+		}
+
+		template <typename RandomAccessIterator, typename Compare>
+		void introSortLoop(RandomAccessIterator first, RandomAccessIterator last, size_t depthLimit, Compare& comp)
+		{
+			while (static_cast<size_t>(last - first) > introSortThreshold)
+			{
+				if (depthLimit == 0)
+				{
+					heapSort(first, last, comp);
+					return;
+				}
+
+				depthLimit--;
+
+				RandomAccessIterator middle = first + (last - first) / 2;
+				moveMedianToFirst(first, first + 1, middle, last - 1, comp);
+				RandomAccessIterator cut = partitionAroundFirst(first, last, comp);
+
+				// Recursing on the smaller side keeps the stack O(log n).
+				if (cut - first < last - cut)
+				{
+					introSortLoop(first, cut, depthLimit, comp);
+					first = cut;
+				}
+				else
+				{
+					introSortLoop(cut, last, depthLimit, comp);
+					last = cut;
+				}
+			}
+
+			networkSort(first, last, comp);
+		}
+	}
+
+	// Introsort (Musser): quicksort with a median-of-three pivot, switching to the bottom-up
+	// heapSort for a range once the recursion gets 2 log2 n deep, which only inputs that
+	// defeat the pivot choice reach, so the worst case is O(n log n). Ranges of at most 16
+	// elements are sorted with the sorting network for their size. Not stable.
+	template <typename RandomAccessIterator, typename Compare>
+	void introSort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+	{
+		size_t depthLimit = 0;
+		for (size_t n = static_cast<size_t>(last - first); n > 1; n /= 2)
+			depthLimit += 2;
+
+		detail::introSortLoop(first, last, depthLimit, comp);
+	}
+
+	template <typename RandomAccessIterator>
+	void introSort(RandomAccessIterator first, RandomAccessIterator last)
+	{
+		introSort(first, last, std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>());
+	}
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace algs {
+
+	namespace detail {
+
+		// Below this many elements per thread, starting a thread costs more than it saves.
+		constexpr size_t mergeGrain = size_t(1) << 15;
+
+		inline unsigned mergeThreads(size_t n, unsigned threadCount)
+		{
+			if (threadCount == 0)
+				threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+			size_t useful = std::max<size_t>(1, n / mergeGrain);
+			return static_cast<unsigned>(std::min<size_t>(threadCount, useful));
+		}
+
+		// Runs body(0) ... body(threadCount - 1) on as many threads, body(0) on the caller's.
+		template <typename TFunc>
+		void runParallel(unsigned threadCount, TFunc body)
+		{
+			std::vector<std::thread> threads;
+			threads.reserve(threadCount - 1);
+
+			for (unsigned t = 1; t < threadCount; t++)
+				threads.emplace_back(body, t);
+
+			body(0);
+
+			for (auto& thread : threads)
+				thread.join();
+		}
+
+		// Co-rank of a diagonal of the merge path: the number i of elements that come from
+		// a in the first diagonal elements of the stable merge of a and b, the other
+		// diagonal - i coming from b. Binary search over the diagonal, O(log min(n1, n2)).
+		template <typename Iterator1, typename Iterator2, typename Compare>
+		size_t coRank(size_t diagonal, Iterator1 a, size_t aSize, Iterator2 b, size_t bSize, Compare comp)
+		{
+			size_t low = diagonal > bSize ? diagonal - bSize : 0;
+			size_t high = std::min(diagonal, aSize);
+
+			// Taking a[mid] is right while it does not come after b[diagonal - mid - 1]:
+			// equal elements are taken from a first.
+			while (low < high)
+			{
+				size_t mid = low + (high - low) / 2;
+
+				if (comp(b[diagonal - mid - 1], a[mid]))
+					high = mid;
+				else
+					low = mid + 1;
+			}
+
+			return low;
+		}
+
+		// Merges [first, middle) and [middle, last) in place with at most buffer.capacity()
+		// elements of extra memory. The smaller run is moved to the buffer and merged back if
+		// it fits; otherwise the merge path is cut in half and a rotation makes the two
+		// halves independent merges.
+		template <typename RandomAccessIterator, typename Compare, typename TValue>
+		void boundedMerge(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last,
+			Compare comp, std::vector<TValue>& buffer)
+		{
+			size_t aSize = static_cast<size_t>(middle - first);
+			size_t bSize = static_cast<size_t>(last - middle);
+
+			if (aSize == 0 || bSize == 0 || !comp(*middle, *(middle - 1)))
+				return;
+
+			if (aSize <= buffer.capacity() && aSize <= bSize)
+			{
+				buffer.assign(std::make_move_iterator(first), std::make_move_iterator(middle));
+
+				// Forward: the output never catches up with the unread part of b, and once
+				// the buffer is empty the rest of b is already in place.
+				auto a = buffer.begin();
+				RandomAccessIterator b = middle;
+				RandomAccessIterator out = first;
+
+				while (a != buffer.end())
+				{
+					if (b != last && comp(*b, *a))
+						*out++ = std::move(*b++);
+					else
+						*out++ = std::move(*a++);
+				}
+
+				buffer.clear();
+				return;
+			}
+
+			if (bSize <= buffer.capacity())
+			{
+				buffer.assign(std::make_move_iterator(middle), std::make_move_iterator(last));
+
+				// Backward, the mirror image.
+				auto b = buffer.end();
+				RandomAccessIterator a = middle;
+				RandomAccessIterator out = last;
+
+				while (b != buffer.begin())
+				{
+					if (a != first && comp(*(b - 1), *(a - 1)))
+						*--out = std::move(*--a);
+					else
+						*--out = std::move(*--b);
+				}
+
+				buffer.clear();
+				return;
+			}
+
+			size_t diagonal = (aSize + bSize) / 2;
+			size_t i = coRank(diagonal, first, aSize, middle, bSize, comp);
+			RandomAccessIterator split = first + diagonal;
+
+			std::rotate(first + i, middle, middle + (diagonal - i));
+
+			boundedMerge(first, first + i, split, comp, buffer);
+			boundedMerge(split, split + (aSize - i), last, comp, buffer);
+		}
+
+		template <typename RandomAccessIterator>
+		void parallelReverse(RandomAccessIterator first, RandomAccessIterator last, unsigned threadCount)
+		{
+			size_t half = static_cast<size_t>(last - first) / 2;
+
+			runParallel(threadCount, [=](unsigned t)
+			{
+				for (size_t k = half * t / threadCount; k < half * (t + 1) / threadCount; k++)
+					std::iter_swap(first + k, last - 1 - k);
+			});
+		}
+
+		// Cuts the merge path into threadCount parts by recursive halving. Each cut is a
+		// rotation, done as three reversals split between the threads of that level.
+		template <typename RandomAccessIterator, typename Compare>
+		void parallelInplaceMerge(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last,
+			Compare comp, unsigned threadCount, size_t bufferSize)
+		{
+			using Value = typename std::iterator_traits<RandomAccessIterator>::value_type;
+
+			if (threadCount <= 1)
+			{
+				std::vector<Value> buffer;
+				buffer.reserve(bufferSize);
+				boundedMerge(first, middle, last, comp, buffer);
+				return;
+			}
+
+			size_t aSize = static_cast<size_t>(middle - first);
+			size_t bSize = static_cast<size_t>(last - middle);
+			unsigned leftThreads = threadCount / 2;
+
+			// Proportional to the threads on each side, so every thread gets the same share.
+			size_t diagonal = (aSize + bSize) * leftThreads / threadCount;
+			size_t i = coRank(diagonal, first, aSize, middle, bSize, comp);
+			RandomAccessIterator left = first + i;
+			RandomAccessIterator right = middle + (diagonal - i);
+			RandomAccessIterator split = first + diagonal;
+
+			parallelReverse(left, middle, threadCount);
+			parallelReverse(middle, right, threadCount);
+			parallelReverse(left, right, threadCount);
+
+			std::thread leftThread([=]()
+			{
+				parallelInplaceMerge(first, left, split, comp, leftThreads, bufferSize);
+			});
+
+			parallelInplaceMerge(split, split + (aSize - i), last, comp, threadCount - leftThreads, bufferSize);
+			leftThread.join();
+		}
+	}
+
+	// Stable merge of the sorted ranges [first1, last1) and [first2, last2) into out, like
+	// std::merge, on threadCount threads (0: one per hardware thread). The output is cut
+	// into equal chunks; each thread finds where its chunk starts in both inputs with a
+	// binary search on the merge path (Odeh, Green et al., "Merge Path") and merges it on
+	// its own, with no synchronization but the final join. Returns the end of the output.
+	// All iterators are random access.
+	template <typename Iterator1, typename Iterator2, typename OutputIterator, typename Compare>
+	OutputIterator parallelMerge(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2,
+		OutputIterator out, Compare comp, unsigned threadCount = 0)
+	{
+		size_t aSize = static_cast<size_t>(last1 - first1);
+		size_t bSize = static_cast<size_t>(last2 - first2);
+		size_t total = aSize + bSize;
+		unsigned threads = detail::mergeThreads(total, threadCount);
+
+		detail::runParallel(threads, [=](unsigned t)
+		{
+			size_t from = total * t / threads;
+			size_t to = total * (t + 1) / threads;
+			size_t i = detail::coRank(from, first1, aSize, first2, bSize, comp);
+			size_t iEnd = detail::coRank(to, first1, aSize, first2, bSize, comp);
+
+			std::merge(first1 + i, first1 + iEnd, first2 + (from - i), first2 + (to - iEnd), out + from, comp);
+		});
+
+		return out + total;
+	}
+
+	template <typename Iterator1, typename Iterator2, typename OutputIterator>
+	OutputIterator parallelMerge(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2, OutputIterator out)
+	{
+		return parallelMerge(first1, last1, first2, last2, out, std::less<typename std::iterator_traits<Iterator1>::value_type>());
+	}
+
+	// Stable in-place merge of the sorted ranges [first, middle) and [middle, last), like
+	// std::inplace_merge, on threadCount threads (0: one per hardware thread), with at most
+	// bufferSize elements of extra memory per thread. std::inplace_merge allocates a buffer
+	// for a whole run where it can.
+	template <typename RandomAccessIterator, typename Compare>
+	void parallelInplaceMerge(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last,
+		Compare comp, unsigned threadCount = 0, size_t bufferSize = 4096)
+	{
+		unsigned threads = detail::mergeThreads(static_cast<size_t>(last - first), threadCount);
+		detail::parallelInplaceMerge(first, middle, last, comp, threads, std::max<size_t>(1, bufferSize));
+	}
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#define ALGS_SORTED_AVX2
+#include <immintrin.h>
+#endif
+
+#if !defined(ALGS_SORTED_AVX2) && defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+// Passes over sorted arrays: isSorted, uniqueSorted and lowerBoundBatch. The templates
+// are portable scalar code; isSorted and uniqueSorted have overloads for int that use
+// AVX2 where the compiler targets it (/arch:AVX2, -mavx2) and fall back to the templates
+// otherwise. lowerBoundBatch has none: gathers were no faster than its interleaved
+// scalar search, whose time goes to cache misses either way.
+namespace algs {
+
+	namespace detail {
+
+		inline void prefetchRead(const void* address)
+		{
+#if defined(_MSC_VER)
+			_mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+			__builtin_prefetch(address);
+#endif
+		}
+
+		// Probes searched side by side by lowerBoundBatch.
+		constexpr size_t searchLanes = 16;
+
+		// Branchless lower bound (Khuong and Morin): the search window only shrinks by a
+		// known amount per step, so the loop has no data-dependent branch to mispredict.
+		template <typename T>
+		size_t lowerBound(const T* data, size_t n, const T& probe)
+		{
+			if (n == 0)
+				return 0;
+
+			const T* base = data;
+			for (size_t length = n; length > 1; )
+			{
+				size_t half = length / 2;
+				base = base[half] < probe ? base + half : base;
+				length -= half;
+			}
+
+			return static_cast<size_t>(base - data) + (*base < probe);
+		}
+	}
+
+	// True if data[0 .. n) is in non-decreasing order.
+	template <typename T>
+	bool isSorted(const T* data, size_t n)
+	{
+		for (size_t i = 1; i < n; i++)
+		{
+			if (data[i] < data[i - 1])
+				return false;
+		}
+
+		return true;
+	}
+
+	// Removes the repeats from sorted data[0 .. n) in place, like std::unique, and returns
+	// the number of distinct elements, which are moved to the front.
+	template <typename T>
+	size_t uniqueSorted(T* data, size_t n)
+	{
+		if (n == 0)
+			return 0;
+
+		size_t out = 1;
+		for (size_t i = 1; i < n; i++)
+		{
+			if (data[out - 1] < data[i])
+				data[out++] = data[i];
+		}
+
+		return out;
+	}
+
+	// For each of probes[0 .. count), the index of the first element of sorted data[0 .. n)
+	// not less than it, written to out, like std::lower_bound. The probes are searched in
+	// groups of detail::searchLanes, one step of each per round, so the cache misses of
+	// a group overlap instead of following one another; each round also prefetches the
+	// element every probe reads next.
+	template <typename T>
+	void lowerBoundBatch(const T* data, size_t n, const T* probes, size_t count, size_t* out)
+	{
+		const size_t lanes = detail::searchLanes;
+		size_t done = 0;
+
+		if (n > 0)
+		{
+			for (; done + lanes <= count; done += lanes)
+			{
+				const T* bases[lanes];
+				for (size_t lane = 0; lane < lanes; lane++)
+					bases[lane] = data;
+
+				for (size_t length = n; length > 1; )
+				{
+					size_t half = length / 2;
+					length -= half;
+
+					for (size_t lane = 0; lane < lanes; lane++)
+					{
+						const T* base = bases[lane];
+						base = base[half] < probes[done + lane] ? base + half : base;
+						detail::prefetchRead(base + length / 2);
+						bases[lane] = base;
+					}
+				}
+
+				for (size_t lane = 0; lane < lanes; lane++)
+					out[done + lane] = static_cast<size_t>(bases[lane] - data) + (*bases[lane] < probes[done + lane]);
+			}
+		}
+
+		for (; done < count; done++)
+			out[done] = detail::lowerBound(data, n, probes[done]);
+	}
+
+#ifdef ALGS_SORTED_AVX2
+
+	namespace detail {
+
+		// For each 8-bit mask of lanes to keep: the indices of those lanes, packed to
+		// the front, and how many there are.
+		struct CompressTable
+		{
+			uint64_t indices[256];
+			uint8_t counts[256];
+
+			CompressTable()
+			{
+				for (unsigned mask = 0; mask < 256; mask++)
+				{
+					uint64_t packed = 0;
+					unsigned kept = 0;
+
+					for (unsigned lane = 0; lane < 8; lane++)
+					{
+						if (mask & (1u << lane))
+							packed |= static_cast<uint64_t>(lane) << (8 * kept++);
+					}
+
+					indices[mask] = packed;
+					counts[mask] = static_cast<uint8_t>(kept);
+				}
+			}
+		};
+
+		inline const CompressTable& compressTable()
+		{
+			static const CompressTable table;
+			return table;
+		}
+	}
+
+	// Compares every element with its successor, eight pairs per instruction.
+	inline bool isSorted(const int* data, size_t n)
+	{
+		size_t i = 0;
+
+		for (; i + 17 <= n; i += 16)
+		{
+			__m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+			__m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+			__m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 8));
+			__m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 9));
+			__m256i descents = _mm256_or_si256(_mm256_cmpgt_epi32(a0, b0), _mm256_cmpgt_epi32(a1, b1));
+
+			if (!_mm256_testz_si256(descents, descents))
+				return false;
+		}
+
+		return isSorted<int>(data + i, n - i);
+	}
+
+	// Eight elements per step: lanes equal to their predecessor are dropped, and a table
+	// lookup gives the shuffle that packs the others to the front. Each store writes
+	// eight lanes, of which only the kept ones count; it never reaches past the elements
+	// already loaded.
+	inline size_t uniqueSorted(int* data, size_t n)
+	{
+		if (n == 0)
+			return 0;
+
+		const detail::CompressTable& table = detail::compressTable();
+		const __m256i previousLanes = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+
+		size_t out = 1;
+		size_t i = 1;
+		int last = data[0];
+
+		for (; i + 8 <= n; i += 8)
+		{
+			__m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+
+			// data[i - 1] may already be overwritten: its value comes from last.
+			__m256i previous = _mm256_insert_epi32(_mm256_permutevar8x32_epi32(current, previousLanes), last, 0);
+			__m256i repeats = _mm256_cmpeq_epi32(current, previous);
+			unsigned keep = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(repeats))) & 0xFF;
+
+			__m256i shuffle = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&table.indices[keep])));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + out), _mm256_permutevar8x32_epi32(current, shuffle));
+
+			out += table.counts[keep];
+			last = _mm256_extract_epi32(current, 7);
+		}
+
+		for (; i < n; i++)
+		{
+			if (data[i] != last)
+				data[out++] = data[i];
+
+			last = data[i];
+		}
+
+		return out;
+	}
+
+#endif
+}
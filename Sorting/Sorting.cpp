@@ -5,6 +5,21 @@
 
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "IndirectSort.h"
+#include "IntroSort.h"
+#include "ParallelMerge.h"
+#include "SortedKernels.h"
+#include "SortingNetwork.h"
+#include "StringSort.h"
 
 using namespace std;
 
@@ -79,17 +94,150 @@ void shell_sort(RandomAccessIterator first, RandomAccessIterator last, Compare c
 
 bool isSorted(const vector<int>& v)
 {
-	size_t lastIndex = std::size(v) - 1;
+	return algs::isSorted(v.data(), v.size());
+}
+
+// 200-byte record that counts how often records are copied or moved.
+struct Record
+{
+	static size_t moves;
+
+	int key;
+	char payload[196];
+
+	Record() : key(0) { }
+
+	Record(const Record& other) : key(other.key)
+	{
+		copy(begin(other.payload), end(other.payload), payload);
+		moves++;
+	}
+
+	Record& operator=(const Record& other)
+	{
+		key = other.key;
+		copy(begin(other.payload), end(other.payload), payload);
+		moves++;
+		return *this;
+	}
+};
+
+size_t Record::moves = 0;
+
+// URL-like keys: a few hosts and directories, so neighbours share long prefixes.
+std::vector<string> makeUrls(size_t n, mt19937& rng)
+{
+	const char* hosts[] = { "https://www.example.com/", "https://docs.example.org/", "https://api.example.net/v2/" };
+	const char* directories[] = { "users/", "images/", "static/css/", "products/catalog/", "blog/2016/" };
 
-	for (auto i = 0; i < lastIndex; i++)
+	std::vector<string> urls(n);
+	for (auto& url : urls)
 	{
-		if (v.at(i) > v.at(i + 1))
-			return false;
+		url = hosts[rng() % 3];
+		url += directories[rng() % 5];
+		url += directories[rng() % 5];
+		url += "item-" + to_string(rng() % 1000000) + ".html";
 	}
 
-	return true;
+	return urls;
+}
+
+// Moves per record since Record::moves was last reset, for measure() to report.
+string movesPerRecord(size_t records)
+{
+	ostringstream out;
+	out << static_cast<double>(Record::moves) / records << " moves per record";
+	return out.str();
+}
+
+template <typename T>
+bool isSorted(const std::vector<T>& values)
+{
+	return is_sorted(values.begin(), values.end());
+}
+
+bool isSorted(const std::vector<Record>& records)
+{
+	return is_sorted(records.begin(), records.end(), [](const Record& left, const Record& right)
+	{
+		return left.key < right.key;
+	});
+}
+
+template <size_t N>
+bool isSorted(const std::vector<array<int, N>>& groups)
+{
+	return all_of(groups.begin(), groups.end(), [](const array<int, N>& group)
+	{
+		return is_sorted(group.begin(), group.end());
+	});
+}
+
+// Runs op on a copy of input and reports the time and whether the copy ended up
+// sorted, followed by what op returned unless it returns nothing.
+template <typename T, typename TOp>
+void measure(const string& name, const std::vector<T>& input, TOp op)
+{
+	std::vector<T> copy = input;
+	string details;
+
+	auto start = chrono::steady_clock::now();
+	if constexpr (is_void_v<decltype(op(copy))>)
+		op(copy);
+	else
+		details = ", " + op(copy);
+	chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+	cout << name << ": " << elapsed.count() << " ms, sorted " << boolalpha << isSorted(copy) << details << endl;
+}
+
+template <typename TSort>
+void measureSortOnInputs(const string& name, const std::vector<int>& random, const std::vector<int>& organPipe, TSort sort)
+{
+	measure(name + ", random", random, sort);
+	measure(name + ", organ pipe", organPipe, sort);
+}
+
+template <size_t N>
+void compareGroupSorts(mt19937& rng)
+{
+	std::vector<array<int, N>> groups(1 << 18);
+	for (auto& group : groups)
+	{
+		for (auto& value : group)
+			value = static_cast<int>(rng() % 1000);
+	}
+
+	cout << groups.size() << " groups of " << N << ", network of " << algs::networkSize<N>() << " comparators" << endl;
+
+	measure("templateShellSort", groups, [](std::vector<array<int, N>>& v)
+	{
+		for (auto& group : v)
+			templateShellSort(group.begin(), group.end(), less<int>());
+	});
+
+	measure("std::sort", groups, [](std::vector<array<int, N>>& v)
+	{
+		for (auto& group : v)
+			sort(group.begin(), group.end());
+	});
+
+	measure("networkSort", groups, [](std::vector<array<int, N>>& v)
+	{
+		for (auto& group : v)
+			algs::networkSort(group);
+	});
+}
+
+// Sorted at compile time.
+constexpr array<int, 5> sortedAtCompileTime()
+{
+	array<int, 5> values = { 5, 1, 4, 2, 3 };
+	algs::networkSort(values);
+	return values;
 }
 
+static_assert(sortedAtCompileTime()[0] == 1 && sortedAtCompileTime()[4] == 5, "networkSort is constexpr");
 
 int main()
 {
@@ -112,6 +260,180 @@ int main()
 	cout << endl;
 	cout << "Sorted: " << boolalpha << isSorted(vector) << endl;
 
+	// Structure of arrays: names follow their keys.
+	std::vector<int> keys = { 3, 1, 2 };
+	std::vector<string> names = { "three", "one", "two" };
+	algs::coSort(keys.begin(), keys.end(), names.begin());
+	cout << "Co-sorted: " << names[0] << " " << names[1] << " " << names[2] << endl;
+
+	mt19937 rng(1);
+	std::vector<Record> records(200000);
+	for (auto& record : records)
+		record.key = static_cast<int>(rng() % 1000000);
+
+	auto byKey = [](const Record& left, const Record& right) { return left.key < right.key; };
+
+	measure("templateShellSort", records, [&byKey](std::vector<Record>& v)
+	{
+		Record::moves = 0;
+		templateShellSort(v.begin(), v.end(), byKey);
+		return movesPerRecord(v.size());
+	});
+
+	measure("std::sort", records, [&byKey](std::vector<Record>& v)
+	{
+		Record::moves = 0;
+		sort(v.begin(), v.end(), byKey);
+		return movesPerRecord(v.size());
+	});
+
+	measure("sortByKey", records, [](std::vector<Record>& v)
+	{
+		Record::moves = 0;
+		algs::sortByKey(v.begin(), v.end(), [](const Record& record) { return record.key; }, less<int>());
+		return movesPerRecord(v.size());
+	});
+
+	std::vector<string> paths = { "/usr/lib", "/usr/bin", "/etc", "/usr/lib/x86", "/usr/bin" };
+	std::vector<size_t> lcp;
+	algs::stringSort(paths.begin(), paths.end(), lcp);
+	for (size_t i = 0; i < paths.size(); i++)
+		cout << lcp[i] << " " << paths[i] << endl;
+
+	std::vector<string> urls = makeUrls(200000, rng);
+	std::vector<string_view> urlViews(urls.begin(), urls.end());
+
+	measure("templateShellSort", urls, [](std::vector<string>& v)
+	{
+		templateShellSort(v.begin(), v.end(), less<string>());
+	});
+
+	measure("std::sort", urls, [](std::vector<string>& v)
+	{
+		sort(v.begin(), v.end());
+	});
+
+	measure("stringSort", urls, [](std::vector<string>& v)
+	{
+		algs::stringSort(v.begin(), v.end());
+	});
+
+	measure("std::sort, string_view", urlViews, [](std::vector<string_view>& v)
+	{
+		sort(v.begin(), v.end());
+	});
+
+	measure("stringSort, string_view", urlViews, [](std::vector<string_view>& v)
+	{
+		algs::stringSort(v.begin(), v.end());
+	});
+
+	// Two sorted runs of 4M ints each.
+	std::vector<int> runs(1 << 23);
+	for (auto& value : runs)
+		value = static_cast<int>(rng() % 100000000);
+
+	size_t middle = runs.size() / 2;
+	sort(runs.begin(), runs.begin() + middle);
+	sort(runs.begin() + middle, runs.end());
+
+	cout << thread::hardware_concurrency() << " hardware threads" << endl;
+
+	measure("std::merge", runs, [middle](std::vector<int>& v)
+	{
+		std::vector<int> out(v.size());
+		merge(v.begin(), v.begin() + middle, v.begin() + middle, v.end(), out.begin());
+		v.swap(out);
+	});
+
+	for (unsigned threads : { 1, 2, 4, 8 })
+	{
+		measure("parallelMerge, " + to_string(threads) + " threads", runs, [middle, threads](std::vector<int>& v)
+		{
+			std::vector<int> out(v.size());
+			algs::parallelMerge(v.begin(), v.begin() + middle, v.begin() + middle, v.end(), out.begin(), less<int>(), threads);
+			v.swap(out);
+		});
+	}
+
+	measure("std::inplace_merge", runs, [middle](std::vector<int>& v)
+	{
+		inplace_merge(v.begin(), v.begin() + middle, v.end());
+	});
+
+	for (unsigned threads : { 1, 2, 4, 8 })
+	{
+		measure("parallelInplaceMerge, " + to_string(threads) + " threads", runs, [middle, threads](std::vector<int>& v)
+		{
+			algs::parallelInplaceMerge(v.begin(), v.begin() + middle, v.end(), less<int>(), threads);
+		});
+	}
+
+	// Post-sort passes over 4M sorted ints with about four copies of each value.
+	std::vector<int> sorted(1 << 22);
+	for (auto& value : sorted)
+		value = static_cast<int>(rng() % (sorted.size() / 4));
+	sort(sorted.begin(), sorted.end());
+
+	measure("std::is_sorted", sorted, [](std::vector<int>& v) { return "result " + to_string(is_sorted(v.begin(), v.end())); });
+	measure("algs::isSorted", sorted, [](std::vector<int>& v) { return "result " + to_string(algs::isSorted(v.data(), v.size())); });
+	measure("std::unique", sorted, [](std::vector<int>& v)
+	{
+		v.resize(unique(v.begin(), v.end()) - v.begin());
+		return "result " + to_string(v.size());
+	});
+	measure("algs::uniqueSorted", sorted, [](std::vector<int>& v)
+	{
+		v.resize(algs::uniqueSorted(v.data(), v.size()));
+		return "result " + to_string(v.size());
+	});
+
+	std::vector<int> probes(1 << 20);
+	for (auto& probe : probes)
+		probe = static_cast<int>(rng() % (sorted.size() / 4));
+
+	std::vector<size_t> positions(probes.size());
+	measure("std::lower_bound", sorted, [&](std::vector<int>& v)
+	{
+		for (size_t i = 0; i < probes.size(); i++)
+			positions[i] = lower_bound(v.begin(), v.end(), probes[i]) - v.begin();
+		return "result " + to_string(positions.back());
+	});
+	measure("algs::lowerBoundBatch", sorted, [&](std::vector<int>& v)
+	{
+		algs::lowerBoundBatch(v.data(), v.size(), probes.data(), probes.size(), positions.data());
+		return "result " + to_string(positions.back());
+	});
+
+	compareGroupSorts<8>(rng);
+	compareGroupSorts<16>(rng);
+
+	// Rising then falling: the middle element is the largest, a poor pivot for a
+	// median of three taken there.
+	std::vector<int> randomValues(1 << 22);
+	for (auto& value : randomValues)
+		value = static_cast<int>(rng());
+	std::vector<int> organPipe(randomValues.size());
+	for (size_t i = 0; i < organPipe.size(); i++)
+		organPipe[i] = static_cast<int>(min(i, organPipe.size() - i));
+
+	measureSortOnInputs("templateShellSort", randomValues, organPipe, [](std::vector<int>& v)
+	{
+		templateShellSort(v.begin(), v.end(), less<int>());
+	});
+	measureSortOnInputs("std::sort", randomValues, organPipe, [](std::vector<int>& v)
+	{
+		sort(v.begin(), v.end());
+	});
+	measureSortOnInputs("algs::heapSort", randomValues, organPipe, [](std::vector<int>& v)
+	{
+		algs::heapSort(v.begin(), v.end());
+	});
+	measureSortOnInputs("algs::introSort", randomValues, organPipe, [](std::vector<int>& v)
+	{
+		algs::introSort(v.begin(), v.end());
+	});
+
 	return 0;
 }
 
@@ -0,0 +1,446 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace algs {
+
+	namespace detail {
+
+		// MSD radix sort over a range of strings: distributes the strings on one character at
+		// a time into 257 buckets (end of string, then the byte values), and goes on with the
+		// next character only inside each bucket. Every character of a shared prefix is read
+		// once per string, where a comparison sort compares the whole prefix again on each of
+		// its O(n log n) comparisons: the difference on URLs or paths. Buckets too small to
+		// pay for 257 counters go to a multikey quicksort, which splits on the characters
+		// into smaller, equal and greater parts, and the smallest to insertion sort.
+		//
+		// The strings themselves stay in place while sorting: a compact key (data pointer,
+		// length, original position) is sorted instead, with the next up to 8 characters of
+		// its string cached in it as one big-endian number. Distributing, partitioning and
+		// skipping a prefix all strings share work on those numbers; a string is read again
+		// only when the sort gets past its cached characters. Distribution keeps the keys in
+		// their original order, so those reads move forward through memory as the strings
+		// were allocated. The strings are moved into order at the end, out and back once.
+		//
+		// Works with anything that has data() and size(): std::string, string_view.
+		// Characters compare as unsigned, like std::string's operator<.
+		template <typename RandomAccessIterator>
+		class StringSorter
+		{
+			typedef typename std::iterator_traits<RandomAccessIterator>::value_type Value;
+
+			struct Key
+			{
+				const char* text;
+				size_t length;
+				size_t index;
+
+				// Characters from the depth of the key's bucket on, in the high bytes; zero
+				// past the end of the string and past what is cached.
+				uint64_t chars;
+			};
+
+			// A range of keys whose strings share their first depth characters, with the
+			// next cached of them in chars.
+			struct Bucket
+			{
+				size_t from;
+				size_t count;
+				size_t depth;
+				size_t cached;
+			};
+
+			static constexpr size_t charsSize = sizeof(uint64_t);
+
+			// Bucket 0 holds the strings that end before the distributing character.
+			static constexpr size_t bucketCount = 257;
+
+			// Below this, partitioning beats a pass over 257 buckets.
+			static constexpr size_t radixThreshold = 256;
+
+			// Below this, insertion sort beats partitioning.
+			static constexpr size_t insertionThreshold = 16;
+
+		public:
+			// lcp may be null. Otherwise it must have room for the whole range.
+			StringSorter(RandomAccessIterator first, size_t n, size_t* lcp) :
+				first(first),
+				lcp(lcp),
+				keys(n),
+				buffer(n)
+			{
+				for (size_t i = 0; i < n; i++)
+				{
+					const auto& s = first[i];
+					keys[i] = Key{ s.data(), s.size(), i, 0 };
+					load(keys[i], 0);
+				}
+			}
+
+			StringSorter(const StringSorter&) = delete;
+			StringSorter& operator=(const StringSorter&) = delete;
+
+			void sort();
+
+		private:
+			static void load(Key& key, size_t depth)
+			{
+				const unsigned char* text = reinterpret_cast<const unsigned char*>(key.text) + depth;
+				size_t left = key.length - depth;
+
+				if (left >= charsSize)
+				{
+					key.chars = uint64_t(text[0]) << 56 | uint64_t(text[1]) << 48 | uint64_t(text[2]) << 40 | uint64_t(text[3]) << 32
+						| uint64_t(text[4]) << 24 | uint64_t(text[5]) << 16 | uint64_t(text[6]) << 8 | uint64_t(text[7]);
+					return;
+				}
+
+				key.chars = 0;
+				for (size_t i = 0; i < charsSize; i++)
+					key.chars = key.chars << 8 | (i < left ? text[i] : 0);
+			}
+
+			// Number of leading bytes two chars have in common.
+			static size_t sameBytes(uint64_t difference)
+			{
+				size_t same = 0;
+				while (same < charsSize && (difference >> (56 - 8 * same) & 0xFF) == 0)
+					same++;
+
+				return same;
+			}
+
+			// Length of the common prefix of two strings of a bucket.
+			static size_t commonPrefix(const Key& left, const Key& right, const Bucket& bucket)
+			{
+				size_t length = std::min(left.length, right.length);
+				size_t depth = bucket.depth + std::min(sameBytes(left.chars ^ right.chars), bucket.cached);
+
+				if (depth >= length)
+					return length;
+
+				if (depth < bucket.depth + bucket.cached)
+					return depth;
+
+				while (depth < length && left.text[depth] == right.text[depth])
+					depth++;
+
+				return depth;
+			}
+
+			// Equal strings keep their original order.
+			static bool less(const Key& left, const Key& right, size_t depth)
+			{
+				if (left.chars != right.chars)
+					return left.chars < right.chars;
+
+				size_t length = std::min(left.length, right.length);
+				int order = length > depth ? std::memcmp(left.text + depth, right.text + depth, length - depth) : 0;
+
+				if (order != 0)
+					return order < 0;
+
+				return left.length != right.length ? left.length < right.length : left.index < right.index;
+			}
+
+			// Moves the keys of a bucket whose strings end before depth + shared to its front,
+			// sorted by length and then original position, and returns how many there are.
+			size_t splitEnded(const Bucket& bucket, size_t shared);
+
+			// Pushes a bucket that needs another step on pending, loading its chars if none
+			// are left.
+			void advance(Bucket bucket, std::vector<Bucket>& pending);
+
+			// One distribution pass. Pushes the buckets that need another step on pending.
+			void distribute(Bucket bucket, std::vector<Bucket>& pending);
+
+			// One partitioning step, the same for a smaller bucket.
+			void partition(const Bucket& bucket, std::vector<Bucket>& pending);
+
+			void insertionSort(const Bucket& bucket);
+
+			void setLcp(size_t index, size_t length)
+			{
+				if (lcp != nullptr)
+					lcp[index] = length;
+			}
+
+		private:
+			RandomAccessIterator first;
+			size_t* lcp;
+
+			std::vector<Key> keys;
+			std::vector<Key> buffer;
+		};
+
+		template <typename RandomAccessIterator>
+		void StringSorter<RandomAccessIterator>::sort()
+		{
+			// Buckets are disjoint, so the order they are sorted in does not matter: an
+			// explicit stack, as a recursion would be as deep as the longest shared prefix.
+			std::vector<Bucket> pending;
+			pending.push_back(Bucket{ 0, keys.size(), 0, charsSize });
+
+			while (!pending.empty())
+			{
+				Bucket bucket = pending.back();
+				pending.pop_back();
+
+				if (bucket.count <= insertionThreshold)
+					insertionSort(bucket);
+				else if (bucket.count < radixThreshold)
+					partition(bucket, pending);
+				else
+					distribute(bucket, pending);
+			}
+
+			// Moving the strings out in order and back is sequential on one side, where
+			// following the cycles of the permutation is random on both.
+			buffer = std::vector<Key>();
+
+			std::vector<Value> sorted;
+			sorted.reserve(keys.size());
+
+			for (const Key& key : keys)
+				sorted.push_back(std::move(first[key.index]));
+
+			std::move(sorted.begin(), sorted.end(), first);
+		}
+
+		template <typename RandomAccessIterator>
+		size_t StringSorter<RandomAccessIterator>::splitEnded(const Bucket& bucket, size_t shared)
+		{
+			Key* range = keys.data() + bucket.from;
+			size_t end = bucket.depth + shared;
+
+			// Stable, so the strings that go on keep their order too.
+			size_t ended = 0;
+			size_t going = 0;
+			for (size_t i = 0; i < bucket.count; i++)
+			{
+				if (range[i].length < end)
+					range[ended++] = range[i];
+				else
+					buffer[going++] = range[i];
+			}
+
+			if (ended == 0)
+				return 0;
+
+			std::memcpy(range + ended, buffer.data(), going * sizeof(Key));
+			std::sort(range, range + ended, [](const Key& left, const Key& right)
+			{
+				return left.length != right.length ? left.length < right.length : left.index < right.index;
+			});
+
+			// An ended string is a prefix of every string after it.
+			for (size_t i = 1; i <= ended && i < bucket.count; i++)
+				setLcp(bucket.from + i, range[i - 1].length);
+
+			return ended;
+		}
+
+		template <typename RandomAccessIterator>
+		void StringSorter<RandomAccessIterator>::advance(Bucket bucket, std::vector<Bucket>& pending)
+		{
+			if (bucket.count < 2)
+				return;
+
+			if (bucket.cached == 0)
+			{
+				Key* range = keys.data() + bucket.from;
+				for (size_t i = 0; i < bucket.count; i++)
+					load(range[i], bucket.depth);
+
+				bucket.cached = charsSize;
+			}
+
+			pending.push_back(bucket);
+		}
+
+		template <typename RandomAccessIterator>
+		void StringSorter<RandomAccessIterator>::distribute(Bucket bucket, std::vector<Bucket>& pending)
+		{
+			Key* range = keys.data() + bucket.from;
+			size_t shared;
+
+			// Skips the characters all the strings share a word at a time, rather than a
+			// pass per character.
+			for (;;)
+			{
+				uint64_t difference = 0;
+				bool ended = false;
+				for (size_t i = 0; i < bucket.count; i++)
+				{
+					difference |= range[i].chars ^ range[0].chars;
+					ended |= range[i].length < bucket.depth + bucket.cached;
+				}
+
+				shared = std::min(sameBytes(difference), bucket.cached);
+				if (shared < bucket.cached)
+					break;
+
+				size_t count = ended ? splitEnded(bucket, shared) : 0;
+				bucket = Bucket{ bucket.from + count, bucket.count - count, bucket.depth + shared, 0 };
+
+				if (bucket.count < radixThreshold)
+				{
+					advance(bucket, pending);
+					return;
+				}
+
+				range = keys.data() + bucket.from;
+				for (size_t i = 0; i < bucket.count; i++)
+					load(range[i], bucket.depth);
+
+				bucket.cached = charsSize;
+			}
+
+			size_t end = bucket.depth + shared;
+			size_t shift = 56 - 8 * shared;
+			size_t counts[bucketCount];
+			std::memset(counts, 0, sizeof(counts));
+
+			for (size_t i = 0; i < bucket.count; i++)
+				counts[range[i].length > end ? (range[i].chars >> shift & 0xFF) + 1 : 0]++;
+
+			size_t starts[bucketCount];
+			size_t start = 0;
+			for (size_t b = 0; b < bucketCount; b++)
+			{
+				starts[b] = start;
+				start += counts[b];
+			}
+
+			// Drops the shared characters and the distributing one from chars on the way.
+			Key* scattered = buffer.data();
+			for (size_t i = 0; i < bucket.count; i++)
+			{
+				Key& to = scattered[starts[range[i].length > end ? (range[i].chars >> shift & 0xFF) + 1 : 0]++];
+				to = range[i];
+				to.chars = shared + 1 < charsSize ? to.chars << 8 * (shared + 1) : 0;
+			}
+
+			std::memcpy(range, scattered, bucket.count * sizeof(Key));
+
+			start = bucket.from;
+			for (size_t b = 0; b < bucketCount; b++)
+			{
+				size_t count = counts[b];
+				if (count == 0)
+					continue;
+
+				if (start != bucket.from)
+					setLcp(start, std::min(end, keys[start - 1].length));
+
+				if (b == 0)
+					splitEnded(Bucket{ start, count, end + 1, 0 }, 0);
+				else
+					advance(Bucket{ start, count, end + 1, bucket.cached - shared - 1 }, pending);
+
+				start += count;
+			}
+		}
+
+		template <typename RandomAccessIterator>
+		void StringSorter<RandomAccessIterator>::partition(const Bucket& bucket, std::vector<Bucket>& pending)
+		{
+			Key* range = keys.data() + bucket.from;
+			size_t n = bucket.count;
+
+			uint64_t a = range[0].chars;
+			uint64_t b = range[n / 2].chars;
+			uint64_t c = range[n - 1].chars;
+			uint64_t pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+
+			// Smaller keys go to [0, smaller), greater ones to [greater, n).
+			size_t smaller = 0;
+			size_t greater = n;
+			for (size_t i = 0; i < greater; )
+			{
+				if (range[i].chars < pivot)
+					std::swap(range[smaller++], range[i++]);
+				else if (range[i].chars > pivot)
+					std::swap(range[i], range[--greater]);
+				else
+					i++;
+			}
+
+			// Neighbours across a boundary are the largest key before it and the smallest
+			// after it: among keys with the same chars, the longest and the shortest.
+			auto byChars = [](const Key& left, const Key& right)
+			{
+				return left.chars < right.chars || (left.chars == right.chars && left.length < right.length);
+			};
+
+			if (lcp != nullptr && smaller > 0)
+				setLcp(bucket.from + smaller, commonPrefix(*std::max_element(range, range + smaller, byChars), range[smaller], bucket));
+
+			if (lcp != nullptr && greater < n)
+				setLcp(bucket.from + greater, commonPrefix(*std::max_element(range + smaller, range + greater, byChars), *std::min_element(range + greater, range + n, byChars), bucket));
+
+			if (smaller > 1)
+				pending.push_back(Bucket{ bucket.from, smaller, bucket.depth, bucket.cached });
+
+			if (n - greater > 1)
+				pending.push_back(Bucket{ bucket.from + greater, n - greater, bucket.depth, bucket.cached });
+
+			Bucket equal{ bucket.from + smaller, greater - smaller, bucket.depth, bucket.cached };
+			size_t ended = splitEnded(equal, bucket.cached);
+			advance(Bucket{ equal.from + ended, equal.count - ended, bucket.depth + bucket.cached, 0 }, pending);
+		}
+
+		template <typename RandomAccessIterator>
+		void StringSorter<RandomAccessIterator>::insertionSort(const Bucket& bucket)
+		{
+			Key* range = keys.data() + bucket.from;
+
+			for (size_t i = 1; i < bucket.count; i++)
+			{
+				Key key = range[i];
+				size_t j = i;
+
+				for (; j > 0 && less(key, range[j - 1], bucket.depth); j--)
+					range[j] = range[j - 1];
+
+				range[j] = key;
+			}
+
+			if (lcp == nullptr)
+				return;
+
+			for (size_t i = 1; i < bucket.count; i++)
+				lcp[bucket.from + i] = commonPrefix(range[i - 1], range[i], bucket);
+		}
+	}
+
+	// Sorts a range of strings (std::string, string_view, ...) in lexicographic order with
+	// an MSD radix sort, which reads the prefix the strings of a bucket have in common once
+	// instead of comparing it again. Stable. Extra memory: about 64 bytes per string.
+	template <typename RandomAccessIterator>
+	void stringSort(RandomAccessIterator first, RandomAccessIterator last)
+	{
+		detail::StringSorter<RandomAccessIterator> sorter(first, static_cast<size_t>(last - first), nullptr);
+		sorter.sort();
+	}
+
+	// Same, and fills lcp with the longest common prefix array of the result: lcp[0] is 0,
+	// lcp[i] the length of the common prefix of the (i-1)-th and i-th sorted strings. It
+	// comes out of the bucket boundaries almost for free, where computing it afterwards
+	// rescans every shared prefix: the input for front coding or a suffix-style index.
+	template <typename RandomAccessIterator>
+	void stringSort(RandomAccessIterator first, RandomAccessIterator last, std::vector<size_t>& lcp)
+	{
+		size_t n = static_cast<size_t>(last - first);
+		lcp.assign(n, 0);
+
+		detail::StringSorter<RandomAccessIterator> sorter(first, n, lcp.data());
+		sorter.sort();
+	}
+}
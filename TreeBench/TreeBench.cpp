@@ -0,0 +1,521 @@
+// TreeBench.cpp : Defines the entry point for the console application.
+//
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include "Workload.h"
+#include "../RBTree/RBTree.h"
+#include "../RBTree/RandomizedBST.h"
+#include "../BSTree/BST.h"
+
+using namespace std;
+
+// Every allocation of the program goes through here, so the bytes a container
+// allocates while it is built are its memory footprint, node headers included.
+static size_t allocatedBytes = 0;
+
+// GCC inlines these into callers and then takes free() for the wrong deallocator
+// of memory from new.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size)
+{
+	allocatedBytes += size;
+
+	if (void* memory = malloc(size != 0 ? size : 1))
+		return memory;
+
+	throw bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+// Common face of the containers under test. scan() visits the keys in [from, to)
+// in order and returns how many it visited: std::map through its iterator, the
+// algs trees through range(), which searches once and then follows parent links,
+// and BST through successor(), one search per step, as it has no ordered walk
+// from a given key.
+template <typename TKey>
+class StdMapAdapter
+{
+public:
+	void insert(const TKey& key, int value)
+	{
+		map.emplace(key, value);
+	}
+
+	bool contains(const TKey& key) const
+	{
+		return map.find(key) != map.end();
+	}
+
+	void remove(const TKey& key)
+	{
+		auto it = map.find(key);
+		if (it != map.end())
+			map.erase(it);
+	}
+
+	size_t scan(const TKey& from, const TKey& to) const
+	{
+		size_t visited = 0;
+		for (auto it = map.lower_bound(from); it != map.end() && it->first < to; ++it)
+			visited++;
+
+		return visited;
+	}
+
+	// Not exposed by std::map.
+	size_t height() const
+	{
+		return 0;
+	}
+
+private:
+	std::map<TKey, int> map;
+};
+
+template <typename TTree, typename TKey>
+class TreeAdapter
+{
+public:
+	void insert(const TKey& key, int value)
+	{
+		tree.insert(key, value);
+	}
+
+	bool contains(const TKey& key) const
+	{
+		return tree.contains(key);
+	}
+
+	void remove(const TKey& key)
+	{
+		tree.remove(key);
+	}
+
+	size_t scan(const TKey& from, const TKey& to) const
+	{
+		return tree.range(from, to, [](const TKey&, int) { });
+	}
+
+	size_t height() const
+	{
+		return tree.height();
+	}
+
+private:
+	TTree tree;
+};
+
+template <typename TKey>
+class BSTAdapter
+{
+public:
+	void insert(const TKey& key, int value)
+	{
+		tree.insert(key, value);
+	}
+
+	bool contains(const TKey& key)
+	{
+		return tree.find(key) != nullptr;
+	}
+
+	void remove(const TKey& key)
+	{
+		tree.remove(key);
+	}
+
+	// from must be present.
+	size_t scan(const TKey& from, const TKey& to)
+	{
+		size_t visited = 0;
+		TKey key = from;
+
+		while (key < to)
+		{
+			visited++;
+
+			TKey* next = tree.successor(key);
+			if (next == nullptr)
+				break;
+
+			key = *next;
+		}
+
+		return visited;
+	}
+
+	size_t height() const
+	{
+		return tree.height();
+	}
+
+private:
+	BST<TKey, int> tree;
+};
+
+enum class Order
+{
+	sequential,
+	random,
+	zipf
+};
+
+const char* orderName(Order order)
+{
+	switch (order)
+	{
+	case Order::sequential: return "sequential";
+	case Order::random: return "random";
+	default: return "zipf 0.99";
+	}
+}
+
+const size_t scanLength = 100;
+
+// Draws ranks of present keys, 0 ... n - 1, in one of the three orders. Zipf ranks
+// go through a fixed permutation, so the hot keys are spread over the key space.
+// nextAbsent() hands out ranks for inserts, each once per n calls: in order for the
+// sequential workload, in the permutation's order otherwise.
+class RankSource
+{
+public:
+	RankSource(Order order, size_t n, const vector<uint32_t>& permutation, uint64_t seed) :
+		order(order),
+		n(n),
+		permutation(permutation),
+		random(seed),
+		zipf(n, 0.99),
+		cursor(0),
+		absentCursor(0)
+	{
+	}
+
+	size_t next()
+	{
+		switch (order)
+		{
+		case Order::sequential: return cursor++ % n;
+		case Order::random: return uniform_int_distribution<size_t>(0, n - 1)(random);
+		default: return permutation[zipf(random) - 1];
+		}
+	}
+
+	size_t nextAbsent()
+	{
+		size_t rank = absentCursor++ % n;
+		return order == Order::sequential ? rank : permutation[rank];
+	}
+
+private:
+	Order order;
+	size_t n;
+	const vector<uint32_t>& permutation;
+	mt19937_64 random;
+	algs::ZipfDistribution zipf;
+	size_t cursor;
+	size_t absentCursor;
+};
+
+enum class OpType
+{
+	find,
+	insert,
+	remove
+};
+
+template <typename TKey>
+struct Op
+{
+	OpType type;
+	TKey key;
+};
+
+// 90% finds of present keys, 5% inserts of absent keys, 5% removes of keys inserted
+// earlier in the mix, oldest first, so the size stays close to n. Present keys have
+// even numbers and inserted ones odd numbers. An odd key comes back only after n
+// inserts, long after the removes took it out again, so no container ever sees a
+// repeated key and the multisets and std::map run the same workload.
+template <typename TKey>
+vector<Op<TKey>> makeMix(RankSource& ranks, size_t count, deque<TKey>& inserted)
+{
+	vector<Op<TKey>> ops;
+	ops.reserve(count);
+	mt19937 dice(count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		unsigned roll = dice() % 100;
+
+		if (roll < 5)
+		{
+			TKey key = algs::BenchmarkKey<TKey>::make(2 * ranks.nextAbsent() + 1);
+			inserted.push_back(key);
+			ops.push_back(Op<TKey>{ OpType::insert, key });
+		}
+		else if (roll < 10 && !inserted.empty())
+		{
+			ops.push_back(Op<TKey>{ OpType::remove, inserted.front() });
+			inserted.pop_front();
+		}
+		else
+		{
+			ops.push_back(Op<TKey>{ OpType::find, algs::BenchmarkKey<TKey>::make(2 * ranks.next()) });
+		}
+	}
+
+	return ops;
+}
+
+template <typename TMap, typename TKey>
+size_t apply(TMap& map, const Op<TKey>& op)
+{
+	switch (op.type)
+	{
+	case OpType::find:
+		return map.contains(op.key) ? 1 : 0;
+	case OpType::insert:
+		map.insert(op.key, 0);
+		return 0;
+	default:
+		map.remove(op.key);
+		return 0;
+	}
+}
+
+struct Result
+{
+	double buildOps;
+	double mixOps;
+	double scannedKeys;
+	double p50;
+	double p99;
+	double p999;
+	double bytesPerEntry;
+	size_t height;
+};
+
+double secondsSince(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+template <typename TMap, typename TKey>
+Result run(Order order, size_t n, size_t opCount, const vector<uint32_t>& permutation)
+{
+	Result result = Result();
+	TMap* map = new TMap();
+
+	// Build from n even keys, generated in chunks outside the timed region.
+	const size_t chunkSize = 1 << 20;
+	vector<TKey> chunk;
+	double buildSeconds = 0;
+	size_t bytesBefore = allocatedBytes;
+	size_t bytesOfKeys = 0;
+
+	for (size_t from = 0; from < n; from += chunkSize)
+	{
+		size_t to = min(n, from + chunkSize);
+		size_t chunkBytes = allocatedBytes;
+
+		chunk.clear();
+		for (size_t i = from; i < to; i++)
+			chunk.push_back(algs::BenchmarkKey<TKey>::make(2 * (order == Order::sequential ? i : permutation[i])));
+
+		bytesOfKeys += allocatedBytes - chunkBytes;
+
+		auto start = chrono::steady_clock::now();
+		for (const TKey& key : chunk)
+			map->insert(key, 0);
+
+		buildSeconds += secondsSince(start);
+	}
+
+	chunk = vector<TKey>();
+	result.buildOps = n / buildSeconds;
+	result.bytesPerEntry = static_cast<double>(allocatedBytes - bytesBefore - bytesOfKeys) / n;
+	result.height = map->height();
+
+	RankSource ranks(order, n, permutation, n);
+	deque<TKey> inserted;
+	size_t hits = 0;
+
+	vector<Op<TKey>> ops = makeMix(ranks, opCount, inserted);
+	auto start = chrono::steady_clock::now();
+	for (const auto& op : ops)
+		hits += apply(*map, op);
+
+	result.mixOps = opCount / secondsSince(start);
+
+	// A second mix, timing every operation on its own. Includes the clock's overhead.
+	ops = makeMix(ranks, opCount, inserted);
+	vector<double> latencies;
+	latencies.reserve(opCount);
+
+	for (const auto& op : ops)
+	{
+		auto opStart = chrono::steady_clock::now();
+		hits += apply(*map, op);
+		latencies.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - opStart).count());
+	}
+
+	auto percentile = [&latencies](double fraction)
+	{
+		size_t index = min(latencies.size() - 1, static_cast<size_t>(fraction * latencies.size()));
+		nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+		return latencies[index];
+	};
+
+	result.p50 = percentile(0.5);
+	result.p99 = percentile(0.99);
+	result.p999 = percentile(0.999);
+
+	// Scans start from present keys and cover scanLength of the even keys, plus any
+	// odd keys the mixes left between them.
+	size_t scanCount = max<size_t>(1, opCount / scanLength);
+	vector<pair<TKey, TKey>> bounds;
+	for (size_t i = 0; i < scanCount; i++)
+	{
+		size_t rank = ranks.next() % (n - scanLength);
+		bounds.push_back(make_pair(algs::BenchmarkKey<TKey>::make(2 * rank), algs::BenchmarkKey<TKey>::make(2 * (rank + scanLength))));
+	}
+
+	size_t scanned = 0;
+	start = chrono::steady_clock::now();
+	for (const auto& bound : bounds)
+		scanned += map->scan(bound.first, bound.second);
+
+	result.scannedKeys = scanned / secondsSince(start);
+
+	if (hits == 0)
+		cout << "No lookup hit" << endl;
+
+	delete map;
+	return result;
+}
+
+void printHeader()
+{
+	cout << setw(16) << "" << setw(10) << "build" << setw(10) << "mix" << setw(9) << "p50"
+		<< setw(9) << "p99" << setw(9) << "p99.9" << setw(10) << "scan" << setw(9) << "bytes" << setw(8) << "height" << endl;
+	cout << setw(16) << "" << setw(10) << "Mops/s" << setw(10) << "Mops/s" << setw(9) << "ns"
+		<< setw(9) << "ns" << setw(9) << "ns" << setw(10) << "Mkeys/s" << setw(9) << "/entry" << setw(8) << "" << endl;
+}
+
+void printRow(const string& name, const Result& result)
+{
+	cout << setw(16) << name << fixed << setprecision(2)
+		<< setw(10) << result.buildOps / 1e6 << setw(10) << result.mixOps / 1e6 << setprecision(0)
+		<< setw(9) << result.p50 << setw(9) << result.p99 << setw(9) << result.p999 << setprecision(2)
+		<< setw(10) << result.scannedKeys / 1e6 << setprecision(1) << setw(9) << result.bytesPerEntry;
+
+	if (result.height != 0)
+		cout << setw(8) << result.height << endl;
+	else
+		cout << setw(8) << "-" << endl;
+
+	cout.unsetf(ios_base::fixed);
+}
+
+// BST has no balancing: a sequential build is quadratic and as deep as it is large.
+const size_t bstSequentialLimit = 10000;
+
+template <typename TKey>
+void runAll(const string& keyName, const vector<size_t>& sizes, size_t opCount)
+{
+	for (size_t n : sizes)
+	{
+		vector<uint32_t> permutation(n);
+		iota(permutation.begin(), permutation.end(), 0);
+		mt19937_64 random(n);
+		shuffle(permutation.begin(), permutation.end(), random);
+
+		for (Order order : { Order::sequential, Order::random, Order::zipf })
+		{
+			cout << endl << keyName << " keys, n = " << n << ", " << orderName(order) << endl;
+			printHeader();
+
+			printRow("std::map", run<StdMapAdapter<TKey>, TKey>(order, n, opCount, permutation));
+			printRow("RBTree", run<TreeAdapter<algs::RBTree<TKey, int>, TKey>, TKey>(order, n, opCount, permutation));
+			printRow("RandomizedBST", run<TreeAdapter<algs::RandomizedBST<TKey, int>, TKey>, TKey>(order, n, opCount, permutation));
+
+			if (order != Order::sequential || n <= bstSequentialLimit)
+				printRow("BST", run<BSTAdapter<TKey>, TKey>(order, n, opCount, permutation));
+			else
+				cout << setw(16) << "BST" << "  skipped, sequential build is quadratic" << endl;
+		}
+	}
+}
+
+// Reads a positive decimal count. Returns false for anything else.
+bool parseCount(const char* text, size_t& value)
+{
+	char* end = nullptr;
+	unsigned long long parsed = strtoull(text, &end, 10);
+
+	if (end == text || *end != '\0' || text[0] == '-' || parsed == 0)
+		return false;
+
+	value = static_cast<size_t>(parsed);
+	return true;
+}
+
+// Usage: TreeBench [maxSize [operations]]. Sizes run from 1K up to maxSize,
+// default 1M, at most 50M; every workload runs the given number of mixed
+// operations twice, once for throughput and once for latencies.
+int main(int argc, char* argv[])
+{
+	size_t maxSize = 1000000;
+	size_t opCount = 200000;
+
+	if (argc > 3
+		|| (argc > 1 && (!parseCount(argv[1], maxSize) || maxSize < 1000))
+		|| (argc > 2 && !parseCount(argv[2], opCount)))
+	{
+		cerr << "Usage: TreeBench [maxSize [operations]]" << endl
+			<< "  maxSize     largest map size, at least 1000 (default 1000000)" << endl
+			<< "  operations  mixed operations per workload (default 200000)" << endl;
+		return 1;
+	}
+
+	vector<size_t> sizes;
+	for (size_t n : { 1000, 10000, 100000, 1000000, 10000000, 50000000 })
+	{
+		if (n <= maxSize)
+			sizes.push_back(n);
+	}
+
+	runAll<int>("int", sizes, opCount);
+	runAll<string>("string", sizes, opCount);
+
+	return 0;
+}
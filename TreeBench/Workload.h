@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace algs {
+
+	// Zipf distribution over the ranks 1 ... n: rank r is drawn with probability
+	// proportional to 1 / r^exponent. Rejection-inversion sampling (Hormann and
+	// Derflinger), so it needs O(1) memory for any n, unlike a table of cumulative
+	// weights, and on average little more than one uniform draw per sample.
+	class ZipfDistribution
+	{
+	public:
+		explicit ZipfDistribution(uint64_t n, double exponent) :
+			n(n),
+			exponent(exponent)
+		{
+			hIntegralX1 = hIntegral(1.5) - 1;
+			hIntegralN = hIntegral(n + 0.5);
+			threshold = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+		}
+
+		template <typename TRandom>
+		uint64_t operator()(TRandom& random)
+		{
+			std::uniform_real_distribution<double> uniform(0, 1);
+
+			for (;;)
+			{
+				double u = hIntegralN + uniform(random) * (hIntegralX1 - hIntegralN);
+				double x = hIntegralInverse(u);
+
+				double rounded = std::floor(x + 0.5);
+				uint64_t k = rounded < 1 ? 1 : rounded > n ? n : static_cast<uint64_t>(rounded);
+
+				if (k - x <= threshold || u >= hIntegral(k + 0.5) - h(static_cast<double>(k)))
+					return k;
+			}
+		}
+
+	private:
+		double h(double x) const
+		{
+			return std::exp(-exponent * std::log(x));
+		}
+
+		// Antiderivative of h, continuous in the exponent around 1.
+		double hIntegral(double x) const
+		{
+			double logX = std::log(x);
+			return expm1Ratio((1 - exponent) * logX) * logX;
+		}
+
+		double hIntegralInverse(double x) const
+		{
+			double t = x * (1 - exponent);
+			if (t < -1)
+				t = -1;
+
+			return std::exp(log1pRatio(t) * x);
+		}
+
+		// expm1(x) / x and log1p(x) / x, with their limit 1 at x = 0.
+		static double expm1Ratio(double x)
+		{
+			return std::fabs(x) > 1e-8 ? std::expm1(x) / x : 1 + x / 2;
+		}
+
+		static double log1pRatio(double x)
+		{
+			return std::fabs(x) > 1e-8 ? std::log1p(x) / x : 1 - x / 2;
+		}
+
+	private:
+		uint64_t n;
+		double exponent;
+		double hIntegralX1;
+		double hIntegralN;
+		double threshold;
+	};
+
+	// Benchmark keys: the i-th key of each type, increasing with i.
+	template <typename TKey>
+	struct BenchmarkKey;
+
+	template <>
+	struct BenchmarkKey<int>
+	{
+		static int make(uint64_t i)
+		{
+			return static_cast<int>(i);
+		}
+	};
+
+	// Zero-padded, so string order matches numeric order. 15 characters: short
+	// enough for the small-string buffer of the common standard libraries.
+	template <>
+	struct BenchmarkKey<std::string>
+	{
+		static std::string make(uint64_t i)
+		{
+			char buffer[32];
+			std::snprintf(buffer, sizeof(buffer), "key:%011llu", static_cast<unsigned long long>(i));
+			return buffer;
+		}
+	};
+}